@@ -0,0 +1,361 @@
+// bernoulli.h - bit parallel Bernoulli and fast binomial variates
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+#pragma once
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "uniform_int.h"
+
+namespace distribution {
+
+	// Indicators with probability p, 64 per mask. Each bit compares a uniform,
+	// generated one engine word per binary digit, against the binary expansion
+	// of p and stops when every bit is decided. The expected number of engine
+	// words per mask is about 8 for general p and at most d for p = k/2^d.
+	class bernoulli_bits {
+		double p_;
+		std::uint64_t m_; // p to 64 binary digits, exact for dyadic p
+		int lo_;          // lowest set digit of m_
+		bool one_;
+	public:
+		typedef bool result_type;
+
+		explicit bernoulli_bits(double p = 0.5)
+			: p_(p), m_(0), lo_(64), one_(p == 1)
+		{
+			if (!(p >= 0 && p <= 1))
+				throw std::invalid_argument("distribution::bernoulli_bits: p must be in [0, 1]");
+
+			if (!one_) {
+				m_ = static_cast<std::uint64_t>(std::ldexp(p, 64));
+				lo_ = m_ ? std::countr_zero(m_) : 64;
+			}
+		}
+		double p() const
+		{
+			return p_;
+		}
+		void reset()
+		{ }
+
+		// L masks at a time, one engine fill per binary digit for all of them
+		template<size_t L, class E>
+		void masks(E& e, std::uint64_t* r) const
+		{
+			check_engine<E>();
+
+			std::uint64_t u[L], w[L];
+			for (size_t i = 0; i < L; ++i) {
+				r[i] = one_ ? ~std::uint64_t(0) : 0;
+				u[i] = ~std::uint64_t(0); // undecided
+			}
+			if (one_)
+				return;
+
+			for (int j = 63; j >= lo_; --j) {
+				words(e, L, w);
+
+				std::uint64_t any = 0;
+				if ((m_ >> j) & 1) {
+					for (size_t i = 0; i < L; ++i) {
+						r[i] |= u[i] & ~w[i]; // uniform digit 0 < 1
+						u[i] &= w[i];
+						any |= u[i];
+					}
+				}
+				else {
+					for (size_t i = 0; i < L; ++i) {
+						u[i] &= ~w[i]; // uniform digit 1 > 0
+						any |= u[i];
+					}
+				}
+				if (!any)
+					break;
+			}
+			// past the last digit of p undecided bits are at least p
+		}
+		template<class E>
+		std::uint64_t mask(E& e) const
+		{
+			std::uint64_t r;
+			masks<1>(e, &r);
+
+			return r;
+		}
+
+		// n packed masks
+		template<class E>
+		void fill(E& e, size_t n, std::uint64_t* m) const
+		{
+			for (; n >= 4; n -= 4, m += 4)
+				masks<4>(e, m);
+			for (; n; --n, ++m)
+				masks<1>(e, m);
+		}
+
+		template<class E>
+		bool operator()(E& e) const
+		{
+			return mask(e) & 1;
+		}
+		// 0 if u <= 1 - p, otherwise 1
+		void quantile(size_t n, const double* u, double* x) const
+		{
+			for (size_t i = 0; i < n; ++i)
+				x[i] = u[i] > 1 - p_;
+		}
+
+		// n indicators as 0 or 1
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			std::uint64_t r[4];
+
+			while (n) {
+				masks<4>(e, r);
+				for (size_t i = 0; i < 4 && n; ++i) {
+					size_t k = n < 64 ? n : 64;
+					for (size_t b = 0; b < k; ++b)
+						x[b] = static_cast<U>((r[i] >> b) & 1);
+					x += k;
+					n -= k;
+				}
+			}
+		}
+	};
+
+	// Binomial with t trials and probability p. Uses inversion for small mean,
+	// popcount of Bernoulli masks for t <= 64, and Hormann's BTRD otherwise.
+	// Blocks take the uniform for inversion and the first BTRD trial from one
+	// engine fill, the few rejected trials draw further words one at a time.
+	// Masks for p that is not dyadic need about 8 engine words each, there is
+	// no separate fast path for general p.
+	// W. Hormann, The generation of binomial random variates, 1993.
+	template<class T = long long>
+	class binomial {
+		T t_;
+		double p_;
+		bool flip_;  // sample t - X(1 - p)
+		double q_;   // min(p, 1 - p)
+		T m_;        // mode
+		double q_n_; // (1 - q)^t for inversion
+		bernoulli_bits bits_;
+		struct {
+			double r, nr, npq, b, a, c, alpha, v_r, u_rv_r;
+		} btrd_;
+
+		static double fc(T k)
+		{
+			static const double table[] = {
+				0.08106146679532726, 0.04134069595540929, 0.02767792568499834,
+				0.02079067210376509, 0.01664469118982119, 0.01387612882307075,
+				0.01189670994589177, 0.01041126526197209, 0.009255462182712733,
+				0.008330563433362871
+			};
+
+			if (k < 10)
+				return table[k];
+
+			double ikp1 = 1./(k + 1);
+
+			return (1./12 - (1./360 - (1./1260)*(ikp1*ikp1))*(ikp1*ikp1))*ikp1;
+		}
+		bool use_inversion() const
+		{
+			return m_ < 11;
+		}
+		bool use_bits() const
+		{
+			return !use_inversion() && t_ <= 64;
+		}
+
+		// smallest x with P(X <= x) >= u
+		T invert(double u) const
+		{
+			double s = q_/(1 - q_), a = (t_ + 1)*s, r = q_n_;
+			T x = 0;
+
+			while (u > r && x < t_) {
+				u -= r;
+				++x;
+				double r1 = (a/x - s)*r;
+				if (r1 < std::numeric_limits<double>::epsilon() && r1 < r)
+					break;
+				r = r1;
+			}
+
+			return x;
+		}
+		// v is the uniform for the first trial
+		template<class E>
+		T btrd(E& e, double v) const
+		{
+			const auto& d = btrd_;
+
+			for (bool first = true; true; first = false) {
+				double u;
+				if (!first)
+					v = uniform01(e);
+				if (v <= d.u_rv_r) {
+					u = v/d.v_r - 0.43;
+
+					return static_cast<T>(std::floor((2*d.a/(0.5 - std::abs(u)) + d.b)*u + d.c));
+				}
+
+				if (v >= d.v_r) {
+					u = uniform01(e) - 0.5;
+				}
+				else {
+					u = v/d.v_r - 0.93;
+					u = (u < 0 ? -0.5 : 0.5) - u;
+					v = uniform01(e)*d.v_r;
+				}
+
+				double us = 0.5 - std::abs(u);
+				double k_ = std::floor((2*d.a/us + d.b)*u + d.c);
+				if (k_ < 0 || k_ > t_)
+					continue;
+				T k = static_cast<T>(k_);
+				v = v*d.alpha/(d.a/(us*us) + d.b);
+				double km = std::abs(static_cast<double>(k - m_));
+
+				if (km <= 15) {
+					// recursive evaluation of f(k)/f(m)
+					double f = 1;
+					if (m_ < k) {
+						for (T i = m_ + 1; i <= k; ++i)
+							f *= d.nr/i - d.r;
+					}
+					else if (m_ > k) {
+						for (T i = k + 1; i <= m_; ++i)
+							v *= d.nr/i - d.r;
+					}
+					if (v <= f)
+						return k;
+				}
+				else {
+					// squeeze then exact test using Stirling corrections
+					v = std::log(v);
+					double rho = (km/d.npq)*(((km/3 + 0.625)*km + 1./6)/d.npq + 0.5);
+					double t = -km*km/(2*d.npq);
+					if (v < t - rho)
+						return k;
+					if (v > t + rho)
+						continue;
+
+					double nm = static_cast<double>(t_ - m_ + 1);
+					double h = (m_ + 0.5)*std::log((m_ + 1)/(d.r*nm)) + fc(m_) + fc(t_ - m_);
+					double nk = static_cast<double>(t_ - k + 1);
+					if (v <= h + (t_ + 1)*std::log(nm/nk) + (k + 0.5)*std::log(nk*d.r/(k + 1)) - fc(k) - fc(t_ - k))
+						return k;
+				}
+			}
+		}
+	public:
+		typedef T result_type;
+
+		explicit binomial(T t = 1, double p = 0.5)
+			: t_(t), p_(p), flip_(p > 0.5), q_(p > 0.5 ? 1 - p : p), bits_(p)
+		{
+			if (t < 0)
+				throw std::invalid_argument("distribution::binomial: t must be non-negative");
+			if (!(p >= 0 && p <= 1))
+				throw std::invalid_argument("distribution::binomial: p must be in [0, 1]");
+
+			m_ = static_cast<T>((t_ + 1)*q_);
+			if (use_inversion()) {
+				q_n_ = std::pow(1 - q_, static_cast<double>(t_));
+			}
+			else {
+				auto& d = btrd_;
+				d.r = q_/(1 - q_);
+				d.nr = (t_ + 1)*d.r;
+				d.npq = t_*q_*(1 - q_);
+				double sqrt_npq = std::sqrt(d.npq);
+				d.b = 1.15 + 2.53*sqrt_npq;
+				d.a = -0.0873 + 0.0248*d.b + 0.01*q_;
+				d.c = t_*q_ + 0.5;
+				d.alpha = (2.83 + 5.1/d.b)*sqrt_npq;
+				d.v_r = 0.92 - 4.2/d.b;
+				d.u_rv_r = 0.86*d.v_r;
+			}
+		}
+		T t() const
+		{
+			return t_;
+		}
+		double p() const
+		{
+			return p_;
+		}
+		T (min)() const
+		{
+			return 0;
+		}
+		T (max)() const
+		{
+			return t_;
+		}
+		void reset()
+		{ }
+
+		template<class E>
+		T operator()(E& e) const
+		{
+			if (q_ == 0)
+				return flip_ ? t_ : 0;
+			if (use_bits())
+				return static_cast<T>(std::popcount(bits_.mask(e) & (~std::uint64_t(0) >> (64 - t_))));
+
+			double u = uniform01(e);
+			T k = use_inversion() ? invert(u) : btrd(e, u);
+
+			return flip_ ? t_ - k : k;
+		}
+
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			check_engine<E>();
+
+			if (q_ == 0 || use_bits()) {
+				if (use_bits() && q_ != 0) {
+					const std::uint64_t low = ~std::uint64_t(0) >> (64 - t_);
+					std::uint64_t r[4];
+					for (; n >= 4; n -= 4, x += 4) {
+						bits_.masks<4>(e, r);
+						for (size_t i = 0; i < 4; ++i)
+							x[i] = static_cast<U>(std::popcount(r[i] & low));
+					}
+				}
+				while (n--)
+					*x++ = static_cast<U>(operator()(e));
+
+				return;
+			}
+
+			constexpr size_t N = 256;
+			std::uint64_t w[N];
+			T k[N];
+			while (n) {
+				size_t m = n < N ? n : N;
+				words(e, m, w);
+				if (use_inversion()) {
+					for (size_t i = 0; i < m; ++i)
+						k[i] = invert((w[i] >> 11)*0x1p-53);
+				}
+				else {
+					for (size_t i = 0; i < m; ++i)
+						k[i] = btrd(e, (w[i] >> 11)*0x1p-53);
+				}
+				for (size_t i = 0; i < m; ++i)
+					x[i] = static_cast<U>(flip_ ? t_ - k[i] : k[i]);
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+} // namespace distribution
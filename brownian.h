@@ -0,0 +1,104 @@
+// brownian.h - Brownian paths refined by bridge sampling
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "quantile.h"
+
+namespace process {
+
+	// Standard Brownian motion W sampled at increasing times starting at W(0) = 0.
+	// New times between samples are drawn from the Brownian bridge between their
+	// neighbours and times past the end by forward increments, so existing
+	// samples never change and refining costs one normal per new time.
+	class brownian_path {
+		std::vector<double> t_, w_;
+	public:
+		brownian_path()
+			: t_(1, 0.), w_(1, 0.)
+		{ }
+		size_t size() const
+		{
+			return t_.size();
+		}
+		const std::vector<double>& times() const
+		{
+			return t_;
+		}
+		const std::vector<double>& values() const
+		{
+			return w_;
+		}
+		void reset()
+		{
+			t_.assign(1, 0.);
+			w_.assign(1, 0.);
+		}
+
+		// add the times in t that are not already sampled
+		template<class E>
+		void refine(E& e, size_t n, const double* t)
+		{
+			// sorting NaN is undefined so check before
+			for (size_t i = 0; i < n; ++i) {
+				if (!(t[i] >= 0 && std::isfinite(t[i])))
+					throw std::invalid_argument("process::brownian_path: times must be finite and non-negative");
+			}
+			std::vector<double> s(t, t + n);
+			std::sort(s.begin(), s.end());
+			s.erase(std::unique(s.begin(), s.end()), s.end());
+			s.erase(std::remove_if(s.begin(), s.end(), [this](double u) {
+				return std::binary_search(t_.begin(), t_.end(), u);
+			}), s.end());
+			if (s.empty())
+				return;
+
+			// one uniform per new time
+			std::vector<double> z(s.size());
+			distribution::inverse::normal().generate(e, z.size(), z.data());
+
+			// merge left to right, each new point conditioned on the last point
+			// and the next existing one
+			std::vector<double> T, W;
+			T.reserve(t_.size() + s.size());
+			W.reserve(t_.size() + s.size());
+			size_t i = 0, j = 0;
+			while (i < t_.size() || j < s.size()) {
+				if (j < s.size() && (i == t_.size() || s[j] < t_[i])) {
+					double a = T.back(), wa = W.back(), u = s[j];
+					if (i < t_.size()) {
+						double b = t_[i], wb = w_[i];
+						W.push_back(wa + (u - a)/(b - a)*(wb - wa) + std::sqrt((u - a)*(b - u)/(b - a))*z[j]);
+					}
+					else {
+						W.push_back(wa + std::sqrt(u - a)*z[j]);
+					}
+					T.push_back(u);
+					++j;
+				}
+				else {
+					T.push_back(t_[i]);
+					W.push_back(w_[i]);
+					++i;
+				}
+			}
+			t_.swap(T);
+			w_.swap(W);
+		}
+
+		// W at sampled times
+		void value(size_t n, const double* t, double* w) const
+		{
+			for (size_t i = 0; i < n; ++i) {
+				auto k = std::lower_bound(t_.begin(), t_.end(), t[i]);
+				if (k == t_.end() || *k != t[i])
+					throw std::invalid_argument("process::brownian_path: time has not been sampled");
+				w[i] = w_[k - t_.begin()];
+			}
+		}
+	};
+
+} // namespace process
@@ -0,0 +1,114 @@
+// copula.h - Gaussian and Student t copulas
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+#pragma once
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "special.h"
+
+namespace distribution {
+
+	// Gaussian copula, or Student t copula with nu degrees of freedom, in d
+	// dimensions. Samples are rows of d uniforms in row major order.
+	class copula {
+		size_t d_;
+		double nu_;
+		std::vector<double> L_; // lower triangular Cholesky factor, row major
+		std::chi_squared_distribution<double> w_;
+
+		// rows of L are reused by this many samples while they are in cache
+		size_t chunk() const
+		{
+			return d_ < 4096 ? 4096/d_ : 1;
+		}
+	public:
+		typedef double result_type;
+
+		// rho is a d x d correlation matrix in row major order, nu = 0 for Gaussian
+		copula(size_t d, const double* rho, double nu = 0)
+			: d_(d), nu_(nu), L_(d*d, 0.), w_(nu > 0 ? nu : 1)
+		{
+			if (d == 0)
+				throw std::invalid_argument("distribution::copula: dimension must be positive");
+			if (nu < 0)
+				throw std::invalid_argument("distribution::copula: degrees of freedom must be non-negative");
+
+			for (size_t j = 0; j < d; ++j) {
+				if (std::fabs(rho[j*d + j] - 1) > 1e-12)
+					throw std::invalid_argument("distribution::copula: correlation matrix must have unit diagonal");
+				for (size_t k = 0; k < j; ++k) {
+					if (std::fabs(rho[j*d + k] - rho[k*d + j]) > 1e-12)
+						throw std::invalid_argument("distribution::copula: correlation matrix must be symmetric");
+				}
+			}
+			// Cholesky-Banachiewicz
+			for (size_t j = 0; j < d; ++j) {
+				double* Lj = &L_[j*d];
+				for (size_t k = 0; k <= j; ++k) {
+					const double* Lk = &L_[k*d];
+					double s = rho[j*d + k];
+					for (size_t i = 0; i < k; ++i)
+						s -= Lj[i]*Lk[i];
+					if (k == j) {
+						if (!(s > 0))
+							throw std::invalid_argument("distribution::copula: correlation matrix must be positive definite");
+						Lj[j] = std::sqrt(s);
+					}
+					else {
+						Lj[k] = s/Lk[k];
+					}
+				}
+			}
+		}
+		size_t dimension() const
+		{
+			return d_;
+		}
+		double nu() const
+		{
+			return nu_;
+		}
+		void reset()
+		{
+			w_.reset();
+		}
+
+		// n samples of d uniforms into u
+		template<class E>
+		void generate(E& e, size_t n, double* u)
+		{
+			standard_normal(e, n*d_, u);
+
+			// z <- L z in place, last coordinate first
+			for (size_t r0 = 0; r0 < n; r0 += chunk()) {
+				size_t r1 = r0 + chunk() < n ? r0 + chunk() : n;
+				for (size_t j = d_; j--; ) {
+					const double* Lj = &L_[j*d_];
+					for (size_t r = r0; r < r1; ++r) {
+						double* z = u + r*d_;
+						double s = 0;
+						for (size_t k = 0; k <= j; ++k)
+							s += Lj[k]*z[k];
+						z[j] = s;
+					}
+				}
+			}
+
+			if (nu_ > 0) {
+				for (size_t r = 0; r < n; ++r) {
+					double* z = u + r*d_;
+					double s = std::sqrt(nu_/w_(e));
+					for (size_t j = 0; j < d_; ++j)
+						z[j] *= s;
+				}
+				student_t_cdf(nu_, n*d_, u, u);
+			}
+			else {
+				normal_cdf(n*d_, u, u);
+			}
+		}
+	};
+
+} // namespace distribution
@@ -0,0 +1,257 @@
+// empirical.h - bootstrap resampling of observed data
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+// D. Politis and J. Romano, The stationary bootstrap, 1994.
+// B. Silverman, Density estimation for statistics and data analysis, 1986.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "pcg.h"
+#include "uniform_int.h"
+
+namespace distribution {
+
+	enum class resample {
+		iid,        // independent draws with replacement
+		block,      // circular blocks of fixed length
+		stationary, // circular blocks of geometric length
+		kernel,     // independent draws plus Gaussian noise
+	};
+
+	// Draws from a contiguous copy of the observations shared by all copies
+	// of the distribution. Block methods wrap around the end of the data and
+	// continue the current block across calls to generate.
+	class empirical {
+		std::shared_ptr<const std::vector<double>> x_;
+		std::shared_ptr<const std::vector<double>> sorted_; // for quantiles
+		resample m_;
+		double b_;        // block length, mean block length for stationary
+		double h_;        // kernel bandwidth
+		double mu_, c_;   // mean and variance correction 1/sqrt(1 + h^2/s^2)
+		double log_q_;    // log(1 - 1/b)
+		std::uint64_t i_; // position in the current block
+		std::uint64_t k_; // values left in the current block
+
+		template<class E>
+		std::uint64_t block_length(E& e) const
+		{
+			if (m_ == resample::block)
+				return static_cast<std::uint64_t>(b_);
+			if (log_q_ == 0)
+				return 1;
+
+			return 1 + static_cast<std::uint64_t>(std::log(uniform_open(e))/log_q_);
+		}
+		template<class E, class U>
+		void gather(E& e, size_t n, U* y) const
+		{
+			constexpr size_t N = 256, D = 16;
+			std::uint64_t j[N];
+			const double* x = x_->data();
+			uniform_int<std::uint64_t> u(0, x_->size() - 1);
+
+			while (n) {
+				size_t m = n < N ? n : N;
+				u.generate(e, m, j);
+				for (size_t i = 0; i < m; ++i) {
+					if (i + D < m)
+						prefetch(x + j[i + D]);
+					y[i] = static_cast<U>(x[j[i]]);
+				}
+				y += m;
+				n -= m;
+			}
+		}
+		// Box-Muller pairs, shrunk so the variance matches the data
+		template<class E, class U>
+		void smooth(E& e, size_t n, U* y) const
+		{
+			constexpr double two_pi = 6.283185307179586;
+
+			gather(e, n, y);
+			for (size_t i = 0; i < n; i += 2) {
+				double r = h_*std::sqrt(-2*std::log(uniform_open(e))), t = two_pi*uniform01(e);
+				y[i] = static_cast<U>(mu_ + (y[i] - mu_ + r*std::cos(t))*c_);
+				if (i + 1 < n)
+					y[i + 1] = static_cast<U>(mu_ + (y[i + 1] - mu_ + r*std::sin(t))*c_);
+			}
+		}
+	public:
+		typedef double result_type;
+
+		// b is the block length, h = 0 uses Silverman's rule of thumb
+		empirical(const double* x, size_t n, resample m = resample::iid, double b = 1, double h = 0)
+			: x_(std::make_shared<const std::vector<double>>(x, x + n)), m_(m), b_(b), h_(h),
+			  mu_(0), c_(1), log_q_(0), i_(0), k_(0)
+		{
+			if (n == 0)
+				throw std::invalid_argument("distribution::empirical: no observations");
+			if (!(b >= 1))
+				throw std::invalid_argument("distribution::empirical: block length must be at least 1");
+			if (h < 0)
+				throw std::invalid_argument("distribution::empirical: bandwidth must be non-negative");
+
+			if (m_ == resample::block)
+				b_ = std::floor(b_);
+			if (m_ == resample::stationary && b_ > 1)
+				log_q_ = std::log1p(-1/b_);
+			if (m_ == resample::kernel) {
+				double s2 = 0;
+				for (double xi : *x_)
+					mu_ += xi;
+				mu_ /= n;
+				for (double xi : *x_)
+					s2 += (xi - mu_)*(xi - mu_);
+				s2 = n > 1 ? s2/(n - 1) : 0;
+
+				if (h_ == 0) {
+					std::vector<double> y(*x_);
+					std::sort(y.begin(), y.end());
+					double iqr = (y[(3*(n - 1))/4] - y[(n - 1)/4])/1.34, s = std::sqrt(s2);
+					double a = iqr > 0 && iqr < s ? iqr : s;
+					h_ = 0.9*a*std::pow(static_cast<double>(n), -0.2);
+				}
+				c_ = s2 > 0 ? 1/std::sqrt(1 + h_*h_/s2) : 1;
+			}
+		}
+		const std::vector<double>& data() const
+		{
+			return *x_;
+		}
+		resample method() const
+		{
+			return m_;
+		}
+		double block() const
+		{
+			return b_;
+		}
+		double bandwidth() const
+		{
+			return h_;
+		}
+		// start a new block on the next draw
+		void reset()
+		{
+			k_ = 0;
+		}
+
+		template<class E>
+		double operator()(E& e)
+		{
+			double y;
+			generate(e, 1, &y);
+
+			return y;
+		}
+
+		// inverse of the empirical distribution function, ignores smoothing
+		void quantile(size_t n, const double* u, double* x)
+		{
+			if (!sorted_) {
+				auto y = std::make_shared<std::vector<double>>(*x_);
+				std::sort(y->begin(), y->end());
+				sorted_ = y;
+			}
+			const double* y = sorted_->data();
+			const double N = static_cast<double>(sorted_->size());
+			for (size_t i = 0; i < n; ++i) {
+				double k = std::ceil(u[i]*N) - 1;
+				x[i] = y[static_cast<size_t>(k < 0 ? 0 : k < N - 1 ? k : N - 1)];
+			}
+		}
+
+		template<class E, class U>
+		void generate(E& e, size_t n, U* y)
+		{
+			check_engine<E>();
+
+			if (m_ == resample::iid) {
+				gather(e, n, y);
+			}
+			else if (m_ == resample::kernel) {
+				smooth(e, n, y);
+			}
+			else {
+				const double* x = x_->data();
+				const std::uint64_t N = x_->size();
+				while (n) {
+					if (k_ == 0) {
+						i_ = bounded(e, N);
+						k_ = block_length(e);
+					}
+					// copy up to the end of the block, the data or the output
+					std::uint64_t k = k_ < N - i_ ? k_ : N - i_;
+					if (k > n)
+						k = n;
+					for (std::uint64_t i = 0; i < k; ++i)
+						y[i] = static_cast<U>(x[i_ + i]);
+					i_ = (i_ + k) % N;
+					k_ -= k;
+					y += k;
+					n -= static_cast<size_t>(k);
+				}
+			}
+		}
+	};
+
+	// R replicates of n draws into the columns of the n by R row major array y
+	// using t threads, 0 for all cores. Replicate r uses the PCG64 DXSM stream
+	// seed_stream(s, r) so the result is the same for any number of threads.
+	// Threads take C neighbouring replicates at a time and write them N rows at
+	// a time so they do not share cache lines of y.
+	template<class U>
+	inline void bootstrap(const empirical& d, std::uint64_t s, size_t R, size_t n, U* y, unsigned t = 0)
+	{
+		constexpr size_t C = 8, N = 256;
+		const size_t tasks = (R + C - 1)/C;
+
+		if (t == 0)
+			t = (std::max)(1u, std::thread::hardware_concurrency());
+		if (t > tasks)
+			t = static_cast<unsigned>(tasks ? tasks : 1);
+
+		std::atomic<size_t> next(0);
+		auto work = [&]() {
+			std::vector<empirical> d_;
+			engine::pcg64dxsm e[C];
+			U x[C][N];
+			for (size_t r0; (r0 = C*next++) < R; ) {
+				size_t c = (std::min)(C, R - r0);
+				d_.assign(c, d);
+				for (size_t k = 0; k < c; ++k) {
+					d_[k].reset();
+					e[k].seed_stream(s, r0 + k);
+				}
+				for (size_t i = 0; i < n; i += N) {
+					size_t m = (std::min)(N, n - i);
+					for (size_t k = 0; k < c; ++k)
+						d_[k].generate(e[k], m, x[k]);
+					for (size_t j = 0; j < m; ++j)
+						for (size_t k = 0; k < c; ++k)
+							y[(i + j)*R + r0 + k] = x[k][j];
+				}
+			}
+		};
+
+		std::vector<std::thread> ts;
+		try {
+			for (unsigned i = 1; i < t; ++i)
+				ts.emplace_back(work);
+		}
+		catch (const std::system_error&) {
+			// run on the threads we have
+		}
+		work();
+		for (auto& th : ts)
+			th.join();
+	}
+
+} // namespace distribution
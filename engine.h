@@ -0,0 +1,192 @@
+// engine.h - engine and seed handle objects
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "xll12/xll/xll.h"
+#include "pool.h"
+#include "stats.h"
+
+namespace engine {
+
+	// std::seed_seq from an array of numbers
+	class seed : public std::seed_seq, public random::pooled<seed> {
+		static std::vector<std::uint32_t> numbers(const xll::OPER& o)
+		{
+			std::vector<std::uint32_t> s;
+
+			if (o.xltype == xltypeNum || o.xltype == xltypeMulti) {
+				for (size_t i = 0; i < o.size(); ++i) {
+					if (o[i].xltype == xltypeNum)
+						s.push_back(static_cast<std::uint32_t>(o[i].val.num));
+				}
+			}
+
+			return s;
+		}
+		seed(const std::vector<std::uint32_t>& s)
+			: std::seed_seq(s.begin(), s.end())
+		{ }
+	public:
+		seed()
+		{ }
+		seed(const xll::OPER& o)
+			: seed(numbers(o))
+		{ }
+	};
+
+	// engines producing the full range of T, usable wherever std engines are
+	template<class T = std::uint64_t>
+	struct base_engine {
+		typedef T result_type;
+
+		static constexpr T (min)()
+		{
+			return 0;
+		}
+		static constexpr T (max)()
+		{
+			return (std::numeric_limits<T>::max)();
+		}
+		virtual ~base_engine()
+		{
+			random::stats::erase(this);
+		}
+		T operator()()
+		{
+			return _next();
+		}
+		// bulk generation without a virtual call per draw
+		void fill(size_t n, T* x)
+		{
+			_fill(n, x);
+		}
+		// new engine of the same type seeded from draws of this one
+		std::unique_ptr<base_engine> split()
+		{
+			return std::unique_ptr<base_engine>(_split());
+		}
+		// new engine in the same state as this one
+		std::unique_ptr<base_engine> clone() const
+		{
+			return std::unique_ptr<base_engine>(_clone());
+		}
+		// seed this engine from its own draws
+		void reseed()
+		{
+			_reseed();
+		}
+	private:
+		virtual T _next() = 0;
+		virtual base_engine* _split() = 0;
+		virtual base_engine* _clone() const = 0;
+		virtual void _reseed() = 0;
+		virtual void _fill(size_t n, T* x)
+		{
+			while (n--)
+				*x++ = _next();
+		}
+	};
+
+	// E if it produces 64 random bits, otherwise combine draws of E
+	template<class E>
+	using bits64 = std::conditional_t<(E::min)() == 0 && (E::max)() == (std::numeric_limits<std::uint64_t>::max)(),
+		E, std::independent_bits_engine<E, 64, std::uint64_t>>;
+
+	// engine state is cache aligned and allocated contiguously from a pool
+	template<class E>
+	class alignas(64) base : public base_engine<>, public random::pooled<base<E>> {
+		bits64<E> e;
+
+		// seed sequence from draws of e
+		std::seed_seq seeds()
+		{
+			std::uint32_t w[8];
+			for (size_t i = 0; i < 8; i += 2) {
+				std::uint64_t x = e();
+				w[i] = static_cast<std::uint32_t>(x);
+				w[i + 1] = static_cast<std::uint32_t>(x >> 32);
+			}
+
+			return std::seed_seq(w, w + 8);
+		}
+	public:
+		base()
+		{ }
+		base(std::seed_seq& s)
+			: e(s)
+		{ }
+	private:
+		std::uint64_t _next() override
+		{
+			return e();
+		}
+		base_engine<>* _split() override
+		{
+			auto s = seeds();
+
+			return new base(s);
+		}
+		base_engine<>* _clone() const override
+		{
+			return new base(*this);
+		}
+		void _reseed() override
+		{
+			auto s = seeds();
+			e.seed(s);
+		}
+		void _fill(size_t n, std::uint64_t* x) override
+		{
+			if constexpr (requires(bits64<E>& e_, size_t k, std::uint64_t* p) { e_.fill(k, p); })
+				e.fill(n, x);
+			else
+				while (n--)
+					*x++ = e();
+		}
+	};
+
+	// engine seeded from draws of r that r's owner cannot invalidate
+	template<class R>
+	inline std::unique_ptr<base_engine<>> split(R& r)
+	{
+		if constexpr (std::is_base_of_v<base_engine<>, R>) {
+			return r.split();
+		}
+		else {
+			std::uint32_t w[8];
+			for (auto& wi : w)
+				wi = static_cast<std::uint32_t>(r());
+			std::seed_seq s(w, w + 8);
+
+			return std::make_unique<base<R>>(s);
+		}
+	}
+
+	// Copy of r in its current state. r is then reseeded from its own draws so
+	// later draws from r do not replay the draws of the copy.
+	template<class R>
+	inline std::unique_ptr<R> fork(R& r)
+	{
+		std::unique_ptr<R> e;
+		if constexpr (std::is_base_of_v<base_engine<>, R>) {
+			e.reset(static_cast<R*>(r.clone().release()));
+			r.reseed();
+		}
+		else {
+			e = std::make_unique<R>(r);
+			std::uint32_t w[8];
+			for (auto& wi : w)
+				wi = static_cast<std::uint32_t>(r());
+			std::seed_seq s(w, w + 8);
+			r.seed(s);
+		}
+
+		return e;
+	}
+
+} // namespace engine
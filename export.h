@@ -0,0 +1,196 @@
+// export.h - stream variates to binary files in bounded memory
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Raw format: a 64 byte export_header followed by rows*columns little-endian
+// IEEE 754 doubles in row major order. Files ending in .npy are written in
+// NumPy format version 1.0 with dtype '<f8' and the same layout.
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace random {
+
+	struct export_header {
+		char magic[8];           // "XLLRAND" and a NUL
+		std::uint32_t version;   // 1
+		std::uint32_t type;      // 1 for float64
+		std::uint64_t rows;
+		std::uint64_t columns;   // values per row, e.g. the length of a path
+		std::uint64_t block;     // rows per block when written
+		std::uint64_t reserved[3];
+	};
+	static_assert(sizeof(export_header) == 64, "export_header must be 64 bytes");
+
+	// destination for blocks of doubles
+	struct sink {
+		virtual ~sink()
+		{ }
+		virtual void write(const double* x, size_t n) = 0;
+		// called after the last write, throws if the data did not reach its destination
+		virtual void close()
+		{ }
+	};
+
+	// true if file should be written in NumPy format, Windows paths ignore case
+	inline bool is_npy(const std::filesystem::path& file)
+	{
+		std::wstring ext = file.extension().wstring();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+
+		return ext == L".npy";
+	}
+
+	class file_sink : public sink {
+		std::ofstream os;
+	public:
+		file_sink(const std::filesystem::path& file)
+			: os(file, std::ios::binary | std::ios::trunc)
+		{
+			if (!os)
+				throw std::runtime_error("random::file_sink: cannot open file");
+		}
+		void header(std::uint64_t rows, std::uint64_t columns, std::uint64_t block)
+		{
+			export_header h = {};
+			std::memcpy(h.magic, "XLLRAND", 8);
+			h.version = 1;
+			h.type = 1;
+			h.rows = rows;
+			h.columns = columns;
+			h.block = block;
+
+			os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		}
+		void npy_header(std::uint64_t rows, std::uint64_t columns)
+		{
+			std::string shape = columns == 1
+				? "(" + std::to_string(rows) + ",)"
+				: "(" + std::to_string(rows) + ", " + std::to_string(columns) + ")";
+			std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': " + shape + ", }";
+			// magic, version and length take 10 bytes, the total is a multiple of 64
+			size_t len = dict.size() + 1;
+			len += (64 - (10 + len)%64)%64;
+			dict.append(len - dict.size() - 1, ' ');
+			dict += '\n';
+
+			os.write("\x93NUMPY\x01\x00", 8);
+			char l[2] = {static_cast<char>(len & 0xFF), static_cast<char>(len >> 8)};
+			os.write(l, 2);
+			os.write(dict.data(), dict.size());
+		}
+		void write(const double* x, size_t n) override
+		{
+			os.write(reinterpret_cast<const char*>(x), n*sizeof(double));
+			if (!os)
+				throw std::runtime_error("random::file_sink: write failed");
+		}
+		// flush and close, the destructor cannot report a failure
+		void close() override
+		{
+			os.close();
+			if (!os)
+				throw std::runtime_error("random::file_sink: close failed");
+		}
+	};
+
+	// Call generate(m, x) for blocks of at most block values and write them
+	// to s. One writer thread takes each block while the next one is being
+	// generated, so only two blocks are ever held in memory.
+	template<class G>
+	inline std::uint64_t stream(G&& generate, std::uint64_t n, sink& s, size_t block = 1 << 16)
+	{
+		std::vector<double> a(block), b(block);
+		std::uint64_t done = 0;
+
+		std::mutex mtx;
+		std::condition_variable cv;
+		const double* pending = nullptr; // block handed to the writer
+		size_t pending_n = 0;
+		bool finished = false;
+		std::exception_ptr error;
+
+		std::thread writer;
+		try {
+			writer = std::thread([&]() {
+				std::unique_lock<std::mutex> lock(mtx);
+				while (true) {
+					cv.wait(lock, [&]() { return pending || finished; });
+					if (!pending)
+						return;
+					lock.unlock();
+					try {
+						s.write(pending, pending_n);
+					}
+					catch (...) {
+						error = std::current_exception();
+					}
+					lock.lock();
+					pending = nullptr;
+					cv.notify_all();
+					if (error)
+						return;
+				}
+			});
+		}
+		catch (const std::system_error&) {
+			// write on this thread
+		}
+
+		// wait for the writer to be idle, then stop it
+		auto stop = [&]() {
+			if (writer.joinable()) {
+				{
+					std::unique_lock<std::mutex> lock(mtx);
+					cv.wait(lock, [&]() { return !pending; });
+					finished = true;
+				}
+				cv.notify_all();
+				writer.join();
+			}
+		};
+
+		try {
+			while (done < n) {
+				size_t m = n - done < block ? static_cast<size_t>(n - done) : block;
+				generate(m, a.data());
+				if (writer.joinable()) {
+					{
+						std::unique_lock<std::mutex> lock(mtx);
+						cv.wait(lock, [&]() { return !pending; });
+						if (error)
+							break;
+						pending = a.data();
+						pending_n = m;
+					}
+					cv.notify_all();
+					a.swap(b);
+				}
+				else {
+					s.write(a.data(), m);
+				}
+				done += m;
+			}
+		}
+		catch (...) {
+			stop();
+			throw;
+		}
+		stop();
+		if (error)
+			std::rethrow_exception(error);
+
+		return done;
+	}
+
+} // namespace random
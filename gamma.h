@@ -0,0 +1,485 @@
+// gamma.h - ziggurat normal, Marsaglia-Tsang gamma and Poisson variates in blocks
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+// G. Marsaglia and W. Tsang, The ziggurat method for generating random variables, 2000.
+// G. Marsaglia and W. Tsang, A simple method for generating gamma variables, 2000.
+// W. Hormann, The transformed rejection method for generating Poisson random variables, 1993.
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "uniform_int.h"
+
+namespace distribution {
+
+	// Standard normal from 128 layers. One engine word gives the layer, the sign
+	// and 53 bits for the abscissa, about 99% of draws need nothing else.
+	class ziggurat {
+		static constexpr double r = 3.442619855899, v = 9.91256303526217e-3;
+
+		struct table {
+			double x[129], f[129];
+			table()
+			{
+				x[0] = v/std::exp(-0.5*r*r);
+				x[1] = r;
+				for (int i = 1; i < 127; ++i)
+					x[i + 1] = std::sqrt(-2*std::log(v/x[i] + std::exp(-0.5*x[i]*x[i])));
+				x[128] = 0;
+				for (int i = 0; i < 129; ++i)
+					f[i] = std::exp(-0.5*x[i]*x[i]);
+			}
+		};
+		static const table& t()
+		{
+			static const table t_;
+
+			return t_;
+		}
+
+		// x from word w failed the rectangle test, finish with the wedge or tail
+		template<class E>
+		static double slow(E& e, std::uint64_t w)
+		{
+			const table& t_ = t();
+
+			while (true) {
+				int i = static_cast<int>(w & 127);
+				double s = (w & 128) ? -1 : 1;
+				double x = ((w >> 11)*0x1p-53)*t_.x[i];
+				if (x < t_.x[i + 1])
+					return s*x;
+				if (i == 0) {
+					double y, a;
+					do {
+						a = -std::log(uniform_open(e))/r;
+						y = -std::log(uniform_open(e));
+					} while (y + y < a*a);
+
+					return s*(r + a);
+				}
+				if (t_.f[i] + uniform01(e)*(t_.f[i + 1] - t_.f[i]) < std::exp(-0.5*x*x))
+					return s*x;
+				w = e();
+			}
+		}
+	public:
+		typedef double result_type;
+
+		void reset()
+		{ }
+		template<class E>
+		double operator()(E& e) const
+		{
+			check_engine<E>();
+
+			return slow(e, e());
+		}
+		// rectangle tests for a block, then the few that fail
+		template<class E, class U>
+		void generate(E& e, size_t n, U* z) const
+		{
+			check_engine<E>();
+
+			constexpr size_t N = 256;
+			const table& t_ = t();
+			std::uint64_t w[N];
+			double y[N];
+			std::uint32_t k[N];
+
+			while (n) {
+				size_t m = n < N ? n : N, nk = 0;
+				words(e, m, w);
+				for (size_t j = 0; j < m; ++j) {
+					int i = static_cast<int>(w[j] & 127);
+					double x = ((w[j] >> 11)*0x1p-53)*t_.x[i];
+					y[j] = (w[j] & 128) ? -x : x;
+					k[nk] = static_cast<std::uint32_t>(j);
+					nk += x >= t_.x[i + 1];
+				}
+				for (size_t j = 0; j < nk; ++j)
+					y[k[j]] = slow(e, w[k[j]]);
+				for (size_t j = 0; j < m; ++j)
+					z[j] = static_cast<U>(y[j]);
+				z += m;
+				n -= m;
+			}
+		}
+	};
+
+	class normal {
+		double mu_, sigma_;
+	public:
+		typedef double result_type;
+
+		explicit normal(double mu = 0, double sigma = 1)
+			: mu_(mu), sigma_(sigma)
+		{
+			if (!(sigma > 0))
+				throw std::invalid_argument("distribution::normal: sigma must be positive");
+		}
+		void reset()
+		{ }
+		template<class E>
+		double operator()(E& e) const
+		{
+			return mu_ + sigma_*ziggurat()(e);
+		}
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			constexpr size_t N = 256;
+			double z[N];
+
+			while (n) {
+				size_t m = n < N ? n : N;
+				ziggurat().generate(e, m, z);
+				for (size_t j = 0; j < m; ++j)
+					x[j] = static_cast<U>(mu_ + sigma_*z[j]);
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+	// Gamma with shape alpha and scale beta. Blocks of candidates are tested
+	// with the squeeze, survivors with the logarithm, and rejects are compacted
+	// and refilled until the block is complete. Shapes below 1 use
+	// gamma(alpha + 1) U^(1/alpha).
+	class gamma {
+		double alpha_, beta_, d_, c_;
+	public:
+		typedef double result_type;
+
+		explicit gamma(double alpha = 1, double beta = 1)
+			: alpha_(alpha), beta_(beta)
+		{
+			if (!(alpha > 0 && beta > 0))
+				throw std::invalid_argument("distribution::gamma: alpha and beta must be positive");
+
+			d_ = (alpha < 1 ? alpha + 1 : alpha) - 1./3;
+			c_ = 1/std::sqrt(9*d_);
+		}
+		double alpha() const
+		{
+			return alpha_;
+		}
+		double beta() const
+		{
+			return beta_;
+		}
+		void reset()
+		{ }
+
+		template<class E>
+		double operator()(E& e) const
+		{
+			double x;
+			generate(e, 1, &x);
+
+			return x;
+		}
+
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			check_engine<E>();
+
+			constexpr size_t N = 256;
+			std::uint64_t w[N];
+			double y[N], z[N], u[N], v[N];
+			std::uint32_t p[N], q[N]; // pending and surviving positions in y
+
+			while (n) {
+				size_t m = n < N ? n : N, np = m;
+				for (size_t j = 0; j < m; ++j)
+					p[j] = static_cast<std::uint32_t>(j);
+
+				while (np) {
+					ziggurat().generate(e, np, z);
+					words(e, np, w);
+
+					// squeeze, branch free
+					size_t nq = 0;
+					for (size_t j = 0; j < np; ++j) {
+						double t = 1 + c_*z[j], z2 = z[j]*z[j];
+						v[j] = t*t*t;
+						u[j] = open01(w[j]);
+						y[p[j]] = d_*v[j];
+						q[nq] = static_cast<std::uint32_t>(j);
+						nq += !(v[j] > 0 && u[j] < 1 - 0.0331*z2*z2);
+					}
+
+					// logarithm test for the survivors, rejects are pending again
+					size_t np_ = 0;
+					for (size_t i = 0; i < nq; ++i) {
+						size_t j = q[i];
+						if (!(v[j] > 0 && std::log(u[j]) < 0.5*z[j]*z[j] + d_*(1 - v[j] + std::log(v[j]))))
+							p[np_++] = p[j];
+					}
+					np = np_;
+				}
+
+				if (alpha_ < 1) {
+					words(e, m, w);
+					for (size_t j = 0; j < m; ++j)
+						y[j] *= std::exp(std::log(open01(w[j]))/alpha_);
+				}
+				for (size_t j = 0; j < m; ++j)
+					x[j] = static_cast<U>(beta_*y[j]);
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+	// One gamma(alpha[i], 1) variate for each shape alpha[i] > 0, using the
+	// same squeeze, compaction and refill as gamma for shapes that vary.
+	template<class E, class U>
+	inline void gamma_each(E& e, size_t n, const double* alpha, U* x)
+	{
+		check_engine<E>();
+
+		constexpr size_t N = 256;
+		std::uint64_t w[N];
+		double y[N], z[N], u[N], v[N], d[N], c[N];
+		std::uint32_t p[N], q[N];
+
+		while (n) {
+			size_t m = n < N ? n : N, np = m;
+			for (size_t j = 0; j < m; ++j) {
+				d[j] = (alpha[j] < 1 ? alpha[j] + 1 : alpha[j]) - 1./3;
+				c[j] = 1/std::sqrt(9*d[j]);
+				p[j] = static_cast<std::uint32_t>(j);
+			}
+
+			while (np) {
+				ziggurat().generate(e, np, z);
+				words(e, np, w);
+
+				size_t nq = 0;
+				for (size_t j = 0; j < np; ++j) {
+					double t = 1 + c[p[j]]*z[j], z2 = z[j]*z[j];
+					v[j] = t*t*t;
+					u[j] = open01(w[j]);
+					y[p[j]] = d[p[j]]*v[j];
+					q[nq] = static_cast<std::uint32_t>(j);
+					nq += !(v[j] > 0 && u[j] < 1 - 0.0331*z2*z2);
+				}
+
+				size_t np_ = 0;
+				for (size_t i = 0; i < nq; ++i) {
+					size_t j = q[i];
+					double dj = d[p[j]];
+					if (!(v[j] > 0 && std::log(u[j]) < 0.5*z[j]*z[j] + dj*(1 - v[j] + std::log(v[j]))))
+						p[np_++] = p[j];
+				}
+				np = np_;
+			}
+
+			words(e, m, w);
+			for (size_t j = 0; j < m; ++j) {
+				if (alpha[j] < 1)
+					y[j] *= std::exp(std::log(open01(w[j]))/alpha[j]);
+				x[j] = static_cast<U>(y[j]);
+			}
+			alpha += m;
+			x += m;
+			n -= m;
+		}
+	}
+
+	// One Poisson(mu[i]) count for each mean mu[i] >= 0. Means below 10 use
+	// inversion from one uniform, larger means Hormann's PTRS where the
+	// cheap acceptance test passes about 86% of the time and the rest are
+	// finished one by one.
+	template<class E, class U>
+	inline void poisson_each(E& e, size_t n, const double* mu, U* k)
+	{
+		check_engine<E>();
+
+		constexpr size_t N = 256;
+		std::uint64_t w[2*N];
+		double y[N];
+		std::uint32_t q[N];
+
+		// PTRS constants for mean m
+		struct ptrs {
+			double b, a, ia, vr, lm;
+			explicit ptrs(double m)
+			{
+				b = 0.931 + 2.53*std::sqrt(m);
+				a = -0.059 + 0.02483*b;
+				ia = 1.1239 + 1.1328/(b - 3.4);
+				vr = 0.9277 - 3.6224/(b - 2);
+				lm = std::log(m);
+			}
+		};
+
+		while (n) {
+			size_t m = n < N ? n : N, nq = 0;
+			words(e, 2*m, w);
+			for (size_t j = 0; j < m; ++j) {
+				double u0 = open01(w[2*j]);
+				if (mu[j] < 10) {
+					double pk = std::exp(-mu[j]), s = pk, kj = 0;
+					while (u0 > s && kj < 1000) {
+						kj += 1;
+						pk *= mu[j]/kj;
+						s += pk;
+					}
+					y[j] = kj;
+				}
+				else {
+					ptrs t(mu[j]);
+					double uj = u0 - 0.5, vj = open01(w[2*j + 1]);
+					double us = 0.5 - std::fabs(uj);
+					y[j] = std::floor((2*t.a/us + t.b)*uj + mu[j] + 0.43);
+					q[nq] = static_cast<std::uint32_t>(j);
+					nq += !(us >= 0.07 && vj <= t.vr);
+				}
+			}
+
+			for (size_t i = 0; i < nq; ++i) {
+				size_t j = q[i];
+				ptrs t(mu[j]);
+				double uj = open01(w[2*j]) - 0.5, vj = open01(w[2*j + 1]);
+				while (true) {
+					double us = 0.5 - std::fabs(uj);
+					double kj = std::floor((2*t.a/us + t.b)*uj + mu[j] + 0.43);
+					if (us >= 0.07 && vj <= t.vr) {
+						y[j] = kj;
+						break;
+					}
+					if (kj >= 0 && !(us < 0.013 && vj > us)
+						&& std::log(vj*t.ia/(t.a/(us*us) + t.b)) <= -mu[j] + kj*t.lm - std::lgamma(kj + 1)) {
+						y[j] = kj;
+						break;
+					}
+					uj = uniform_open(e) - 0.5;
+					vj = uniform_open(e);
+				}
+			}
+
+			for (size_t j = 0; j < m; ++j)
+				k[j] = static_cast<U>(y[j]);
+			mu += m;
+			k += m;
+			n -= m;
+		}
+	}
+
+	class chi_squared {
+		gamma g_;
+	public:
+		typedef double result_type;
+
+		explicit chi_squared(double k = 1, double = 0)
+			: g_(k/2, 2)
+		{ }
+		double k() const
+		{
+			return 2*g_.alpha();
+		}
+		void reset()
+		{ }
+		template<class E>
+		double operator()(E& e) const
+		{
+			return g_(e);
+		}
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			g_.generate(e, n, x);
+		}
+	};
+
+	// Z/sqrt(chi-squared(nu)/nu) from a block of ziggurat normals
+	class student_t {
+		double nu_;
+		gamma g_;
+	public:
+		typedef double result_type;
+
+		explicit student_t(double nu = 1, double = 0)
+			: nu_(nu), g_(nu/2, 2/nu)
+		{ }
+		double nu() const
+		{
+			return nu_;
+		}
+		void reset()
+		{ }
+		template<class E>
+		double operator()(E& e) const
+		{
+			double x;
+			generate(e, 1, &x);
+
+			return x;
+		}
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			constexpr size_t N = 256;
+			double z[N], g[N];
+
+			while (n) {
+				size_t m = n < N ? n : N;
+				ziggurat().generate(e, m, z);
+				g_.generate(e, m, g);
+				for (size_t j = 0; j < m; ++j)
+					x[j] = static_cast<U>(z[j]/std::sqrt(g[j]));
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+	// (chi-squared(m)/m)/(chi-squared(n)/n)
+	class fisher_f {
+		gamma gm_, gn_;
+	public:
+		typedef double result_type;
+
+		fisher_f(double m = 1, double n = 1)
+			: gm_(m/2, 2/m), gn_(n/2, 2/n)
+		{ }
+		double m() const
+		{
+			return 2*gm_.alpha();
+		}
+		double n() const
+		{
+			return 2*gn_.alpha();
+		}
+		void reset()
+		{ }
+		template<class E>
+		double operator()(E& e) const
+		{
+			double x;
+			generate(e, 1, &x);
+
+			return x;
+		}
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			constexpr size_t N = 256;
+			double a[N], b[N];
+
+			while (n) {
+				size_t k = n < N ? n : N;
+				gm_.generate(e, k, a);
+				gn_.generate(e, k, b);
+				for (size_t j = 0; j < k; ++j)
+					x[j] = static_cast<U>(a[j]/b[j]);
+				x += k;
+				n -= k;
+			}
+		}
+	};
+
+} // namespace distribution
@@ -0,0 +1,265 @@
+// job.h - asynchronous generation on a thread pool
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// A job calls generate(m, x) for consecutive blocks on a pool thread. Progress
+// and cancellation are checked between blocks and completion is signalled
+// through a shared future, so callers can poll or wait.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "export.h"
+
+namespace random {
+
+	class thread_pool {
+		std::mutex m_;
+		std::condition_variable cv_;
+		std::deque<std::function<void()>> q_;
+		std::vector<std::thread> ts_;
+		bool stop_;
+
+		void spawn(unsigned n)
+		{
+			if (n == 0)
+				n = (std::max)(1u, std::thread::hardware_concurrency());
+			for (unsigned i = 0; i < n; ++i)
+				ts_.emplace_back(&thread_pool::work, this);
+		}
+		void work()
+		{
+			while (true) {
+				std::function<void()> f;
+				{
+					std::unique_lock<std::mutex> lock(m_);
+					cv_.wait(lock, [this] { return stop_ || !q_.empty(); });
+					if (q_.empty())
+						return;
+					f = std::move(q_.front());
+					q_.pop_front();
+				}
+				f();
+			}
+		}
+	public:
+		explicit thread_pool(unsigned n = 0)
+			: stop_(false)
+		{
+			spawn(n);
+		}
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+		~thread_pool()
+		{
+			stop();
+		}
+		static thread_pool& instance()
+		{
+			static thread_pool p;
+
+			return p;
+		}
+
+		void submit(std::function<void()> f)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_);
+				if (stop_)
+					throw std::runtime_error("random::thread_pool: pool is stopped");
+				q_.push_back(std::move(f));
+			}
+			cv_.notify_one();
+		}
+		// run queued tasks then join the threads
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_);
+				stop_ = true;
+			}
+			cv_.notify_all();
+			for (auto& t : ts_) {
+				if (t.joinable())
+					t.join();
+			}
+		}
+		// accept tasks again after stop
+		void start(unsigned n = 0)
+		{
+			std::lock_guard<std::mutex> lock(m_);
+			if (!stop_)
+				return;
+			ts_.clear();
+			stop_ = false;
+			spawn(n);
+		}
+	};
+
+	// The pool task shares the state of a job, so a job handle can be
+	// destroyed without waiting for its task to be picked up or finish.
+	class job {
+	public:
+		enum class status { queued, running, done, cancelled, failed };
+
+		// bytes of results all jobs without a sink may hold at once
+		static inline std::uint64_t memory_limit = std::uint64_t(1) << 30;
+	private:
+		static inline std::atomic<std::uint64_t> reserved_ = 0;
+		static inline std::atomic<bool> cancel_all_ = false;
+
+		struct task {
+			std::function<void(size_t, double*)> g;
+			std::unique_ptr<sink> s; // results are kept in x if null
+			std::vector<double> x;
+			std::uint64_t n;
+			size_t block;
+			std::atomic<std::uint64_t> done;
+			std::atomic<bool> cancel;
+			std::atomic<status> status_;
+			std::exception_ptr error;
+			std::promise<void> p;
+			std::shared_future<void> f;
+
+			task(std::function<void(size_t, double*)> g, std::uint64_t n, std::unique_ptr<sink> s, size_t block)
+				: g(std::move(g)), s(std::move(s)), n(n), block(block ? block : 1),
+				  done(0), cancel(false), status_(status::queued), f(p.get_future().share())
+			{
+				if (!this->s) {
+					std::uint64_t bytes = n*sizeof(double), r = reserved_;
+					do {
+						if (r + bytes > memory_limit)
+							throw std::runtime_error("random::job: memory limit exceeded");
+					} while (!reserved_.compare_exchange_weak(r, r + bytes));
+					try {
+						x.resize(static_cast<size_t>(n));
+					}
+					catch (...) {
+						reserved_ -= bytes;
+						throw;
+					}
+				}
+			}
+			task(const task&) = delete;
+			task& operator=(const task&) = delete;
+			~task()
+			{
+				if (!s)
+					reserved_ -= n*sizeof(double);
+			}
+
+			void run()
+			{
+				status r = status::done;
+
+				if (cancel || cancel_all_) {
+					r = status::cancelled;
+				}
+				else {
+					status_ = status::running;
+					try {
+						std::vector<double> buf(s ? block : 0);
+						while (done < n) {
+							if (cancel || cancel_all_) {
+								r = status::cancelled;
+								break;
+							}
+							size_t m = n - done < block ? static_cast<size_t>(n - done) : block;
+							double* y = s ? buf.data() : x.data() + done;
+							g(m, y);
+							if (s)
+								s->write(y, m);
+							done += m;
+						}
+						if (s && r == status::done)
+							s->close();
+					}
+					catch (...) {
+						error = std::current_exception();
+						r = status::failed;
+					}
+				}
+
+				status_ = r;
+				p.set_value();
+			}
+		};
+		std::shared_ptr<task> s_;
+	public:
+		// n values from generate in blocks, written to s or kept in memory if s is null
+		job(std::function<void(size_t, double*)> generate, std::uint64_t n,
+			std::unique_ptr<sink> s = nullptr, size_t block = 1 << 16, thread_pool& pool = thread_pool::instance())
+			: s_(std::make_shared<task>(std::move(generate), n, std::move(s), block))
+		{
+			pool.submit([s = s_] { s->run(); });
+		}
+		job(const job&) = delete;
+		job& operator=(const job&) = delete;
+		// the task stops after its current block, or when it is dequeued
+		~job()
+		{
+			cancel();
+		}
+
+		std::uint64_t size() const
+		{
+			return s_->n;
+		}
+		std::uint64_t done() const
+		{
+			return s_->done;
+		}
+		double progress() const
+		{
+			return s_->n ? static_cast<double>(s_->done)/s_->n : 1;
+		}
+		status state() const
+		{
+			return s_->status_;
+		}
+		bool ready() const
+		{
+			return s_->f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+		// stop after the current block
+		void cancel()
+		{
+			s_->cancel = true;
+		}
+		// stop every job after its current block
+		static void cancel_all()
+		{
+			cancel_all_ = true;
+		}
+		// let new jobs run after cancel_all
+		static void resume_all()
+		{
+			cancel_all_ = false;
+		}
+		std::shared_future<void> future() const
+		{
+			return s_->f;
+		}
+		// values kept in memory once the job is done, rethrows a failure
+		const std::vector<double>& result() const
+		{
+			s_->f.wait();
+			if (s_->error)
+				std::rethrow_exception(s_->error);
+			if (s_->status_ == status::cancelled)
+				throw std::runtime_error("random::job: job was cancelled");
+
+			return s_->x;
+		}
+	};
+
+} // namespace random
@@ -0,0 +1,222 @@
+// pcg.h - PCG64 DXSM engine with interleaved lanes
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// 128-bit LCG with the cheap 64-bit multiplier and the DXSM output function
+// of numpy's PCG64DXSM. See https://www.pcg-random.org/
+#pragma once
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include "uniform_int.h"
+
+namespace engine {
+
+	// unsigned 128-bit arithmetic mod 2^128
+	struct uint128 {
+		std::uint64_t lo, hi;
+
+		friend uint128 operator+(uint128 a, uint128 b)
+		{
+			uint128 c{a.lo + b.lo, a.hi + b.hi};
+			c.hi += c.lo < a.lo;
+
+			return c;
+		}
+		friend uint128 operator*(uint128 a, uint128 b)
+		{
+			uint128 c;
+			c.hi = distribution::mul128(a.lo, b.lo, &c.lo) + a.hi*b.lo + a.lo*b.hi;
+
+			return c;
+		}
+		friend bool operator==(uint128 a, uint128 b)
+		{
+			return a.lo == b.lo && a.hi == b.hi;
+		}
+	};
+
+	// L streams with distinct increments advanced together. The 64 x 64 -> 128
+	// bit multiply has no vector instruction and throughput is bound by the
+	// multiplier, so lanes give independent streams rather than speed.
+	template<size_t L = 1>
+	class pcg64x {
+		static constexpr std::uint64_t cheap = 0xda942042e4dd58b5;
+
+		alignas(64) std::uint64_t lo[L], hi[L];       // state
+		alignas(64) std::uint64_t inc_lo[L], inc_hi[L]; // odd increments
+		alignas(64) std::uint64_t buf[L];
+		size_t i_;
+
+		// output from the state before the step, as numpy does
+		void step(std::uint64_t* x)
+		{
+			steps(1, x);
+		}
+		// m steps of every lane into x with the state held in registers
+		void steps(size_t m, std::uint64_t* x)
+		{
+			std::uint64_t l_[L], h_[L], il[L], ih[L];
+			for (size_t k = 0; k < L; ++k) {
+				l_[k] = lo[k];
+				h_[k] = hi[k];
+				il[k] = inc_lo[k];
+				ih[k] = inc_hi[k];
+			}
+			for (; m; --m, x += L) {
+				for (size_t k = 0; k < L; ++k) {
+					std::uint64_t h = h_[k];
+					h ^= h >> 32;
+					h *= cheap;
+					h ^= h >> 48;
+					x[k] = h*(l_[k] | 1);
+
+					std::uint64_t p_lo, p_hi = distribution::mul128(l_[k], cheap, &p_lo) + h_[k]*cheap;
+					l_[k] = p_lo + il[k];
+					h_[k] = p_hi + ih[k] + (l_[k] < p_lo);
+				}
+			}
+			for (size_t k = 0; k < L; ++k) {
+				lo[k] = l_[k];
+				hi[k] = h_[k];
+			}
+		}
+		static std::uint64_t splitmix64(std::uint64_t& x)
+		{
+			std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27))*0x94d049bb133111eb;
+
+			return z ^ (z >> 31);
+		}
+		void advance(size_t k, uint128 delta)
+		{
+			// Brown, Random number generation with arbitrary strides, 1994.
+			uint128 acc_mult{1, 0}, acc_plus{0, 0}, cur_mult{cheap, 0}, cur_plus{inc_lo[k], inc_hi[k]};
+			while (delta.lo | delta.hi) {
+				if (delta.lo & 1) {
+					acc_mult = acc_mult*cur_mult;
+					acc_plus = acc_plus*cur_mult + cur_plus;
+				}
+				cur_plus = (cur_mult + uint128{1, 0})*cur_plus;
+				cur_mult = cur_mult*cur_mult;
+				delta.lo = (delta.lo >> 1) | (delta.hi << 63);
+				delta.hi >>= 1;
+			}
+			uint128 s = acc_mult*uint128{lo[k], hi[k]} + acc_plus;
+			lo[k] = s.lo;
+			hi[k] = s.hi;
+		}
+	public:
+		typedef std::uint64_t result_type;
+		static constexpr size_t lanes = L;
+		static constexpr std::uint64_t default_seed = 0xcafef00dd15ea5e5;
+
+		static constexpr result_type (min)()
+		{
+			return 0;
+		}
+		static constexpr result_type (max)()
+		{
+			return ~result_type(0);
+		}
+
+		explicit pcg64x(std::uint64_t s = default_seed)
+		{
+			seed(uint128{s, 0}, uint128{0, 0});
+		}
+		// seed sequences only, so copying a non-const engine is not a reseed
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, pcg64x>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		explicit pcg64x(Sseq& q)
+		{
+			seed(q);
+		}
+
+		// lane k uses stream seq + k
+		void seed(uint128 state, uint128 seq)
+		{
+			for (size_t k = 0; k < L; ++k) {
+				uint128 s = seq + uint128{k, 0};
+				inc_hi[k] = (s.hi << 1) | (s.lo >> 63);
+				inc_lo[k] = (s.lo << 1) | 1;
+				lo[k] = 0;
+				hi[k] = 0;
+				advance(k, uint128{1, 0});
+				uint128 t = uint128{lo[k], hi[k]} + state;
+				lo[k] = t.lo;
+				hi[k] = t.hi;
+				advance(k, uint128{1, 0});
+			}
+			i_ = L;
+		}
+		void seed(std::uint64_t s = default_seed)
+		{
+			seed(uint128{s, 0}, uint128{0, 0});
+		}
+		// Stream k of seed s. Streams that differ only in their increment are
+		// correlated, so the state and the increment are both hashed from (s, k).
+		void seed_stream(std::uint64_t s, std::uint64_t k)
+		{
+			std::uint64_t x = splitmix64(s) ^ k, w[4];
+			for (auto& wi : w)
+				wi = splitmix64(x);
+			seed(uint128{w[0], w[1]}, uint128{w[2], w[3]});
+		}
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, pcg64x>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		void seed(Sseq& q)
+		{
+			std::uint32_t w[8];
+			q.generate(w, w + 8);
+			seed(uint128{(std::uint64_t(w[1]) << 32) | w[0], (std::uint64_t(w[3]) << 32) | w[2]},
+				uint128{(std::uint64_t(w[5]) << 32) | w[4], (std::uint64_t(w[7]) << 32) | w[6]});
+		}
+
+		result_type operator()()
+		{
+			if constexpr (L == 1) {
+				result_type x;
+				step(&x);
+
+				return x;
+			}
+			else {
+				if (i_ == L) {
+					step(buf);
+					i_ = 0;
+				}
+
+				return buf[i_++];
+			}
+		}
+		void fill(size_t n, result_type* x)
+		{
+			while (n && i_ < L) {
+				*x++ = buf[i_++];
+				--n;
+			}
+			steps(n/L, x);
+			x += n - n%L;
+			n %= L;
+			while (n--)
+				*x++ = operator()();
+		}
+		// skip n outputs in O(log n) multiplications
+		void discard(unsigned long long n)
+		{
+			while (n && i_ < L) {
+				++i_;
+				--n;
+			}
+			for (size_t k = 0; k < L; ++k)
+				advance(k, uint128{n/L, 0});
+			for (n %= L; n; --n)
+				operator()();
+		}
+	};
+
+	typedef pcg64x<> pcg64dxsm;
+	typedef pcg64x<4> pcg64dxsm_x4;
+
+} // namespace engine
@@ -0,0 +1,154 @@
+// pool.h - typed slab allocator for handle objects
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Objects are carved from cache aligned slabs and freed slots are reused
+// first, so superseded handles do not churn the heap.
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <typeinfo>
+#include <vector>
+
+namespace random {
+
+	// memory held by a pool
+	struct footprint {
+		const char* type;
+		size_t size;  // bytes per slot
+		size_t slots; // slots allocated
+		size_t used;  // live objects
+		size_t bytes() const
+		{
+			return size*slots;
+		}
+	};
+
+	class pool_base {
+		static std::mutex& registry_mutex()
+		{
+			static std::mutex m;
+
+			return m;
+		}
+		static std::vector<pool_base*>& registry()
+		{
+			static auto* p = new std::vector<pool_base*>; // never destroyed
+
+			return *p;
+		}
+	protected:
+		pool_base()
+		{
+			std::lock_guard<std::mutex> lock(registry_mutex());
+			registry().push_back(this);
+		}
+	public:
+		pool_base(const pool_base&) = delete;
+		pool_base& operator=(const pool_base&) = delete;
+		virtual ~pool_base()
+		{ }
+		virtual footprint report() = 0;
+
+		// footprint of every pool in use
+		static std::vector<footprint> reports()
+		{
+			std::lock_guard<std::mutex> lock(registry_mutex());
+			std::vector<footprint> f;
+			for (auto p : registry())
+				f.push_back(p->report());
+
+			return f;
+		}
+	};
+
+	template<class T>
+	class pool : public pool_base {
+		static constexpr size_t align = alignof(T) > 64 ? alignof(T) : 64;
+		union alignas(align) slot {
+			slot* next;
+			unsigned char data[sizeof(T)];
+		};
+		static constexpr size_t slab_bytes = 1 << 16;
+		static constexpr size_t per_slab = sizeof(slot) < slab_bytes ? slab_bytes/sizeof(slot) : 1;
+
+		std::mutex m;
+		std::vector<slot*> slabs;
+		slot* free_ = nullptr;
+		size_t used = 0;
+
+		pool()
+		{ }
+	public:
+		// handles can outlive static destruction so the pool never is destroyed
+		static pool& instance()
+		{
+			static pool* p = new pool;
+
+			return *p;
+		}
+
+		void* allocate()
+		{
+			std::lock_guard<std::mutex> lock(m);
+
+			if (!free_) {
+				slot* s = static_cast<slot*>(::operator new(per_slab*sizeof(slot), std::align_val_t(align)));
+				slabs.push_back(s);
+				for (size_t i = per_slab; i--; ) {
+					s[i].next = free_;
+					free_ = s + i;
+				}
+			}
+
+			slot* s = free_;
+			free_ = s->next;
+			++used;
+
+			return s;
+		}
+		void deallocate(void* p)
+		{
+			std::lock_guard<std::mutex> lock(m);
+
+			slot* s = static_cast<slot*>(p);
+			s->next = free_;
+			free_ = s;
+			--used;
+		}
+
+		footprint report() override
+		{
+			std::lock_guard<std::mutex> lock(m);
+
+			return footprint{typeid(T).name(), sizeof(slot), slabs.size()*per_slab, used};
+		}
+	};
+
+	// derive T from pooled<T> to allocate T from pool<T>
+	template<class T>
+	struct pooled {
+		static void* operator new(size_t n)
+		{
+			return n == sizeof(T) ? pool<T>::instance().allocate() : ::operator new(n);
+		}
+		static void* operator new(size_t n, std::align_val_t a)
+		{
+			return n == sizeof(T) ? pool<T>::instance().allocate() : ::operator new(n, a);
+		}
+		static void operator delete(void* p, size_t n)
+		{
+			if (n == sizeof(T))
+				pool<T>::instance().deallocate(p);
+			else
+				::operator delete(p);
+		}
+		static void operator delete(void* p, size_t n, std::align_val_t a)
+		{
+			if (n == sizeof(T))
+				pool<T>::instance().deallocate(p);
+			else
+				::operator delete(p, a);
+		}
+	};
+
+} // namespace random
@@ -0,0 +1,345 @@
+// quantile.h - distributions generated by inverting their distribution function
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Every variate uses exactly one engine word, so distributions sharing an
+// engine state, or a block of uniforms, produce common random numbers.
+// M. Wichura, Algorithm AS 241: The percentage points of the normal distribution, 1988.
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include "special.h"
+
+namespace distribution::inverse {
+
+	// Q provides the scalar quantile q(u) for u in (0, 1)
+	template<class Q>
+	struct base {
+		typedef double result_type;
+
+		void reset()
+		{ }
+		void quantile(size_t n, const double* u, double* x) const
+		{
+			const Q& q = static_cast<const Q&>(*this);
+			for (size_t i = 0; i < n; ++i)
+				x[i] = q.q(u[i]);
+		}
+		template<class E>
+		double operator()(E& e) const
+		{
+			return static_cast<const Q&>(*this).q(uniform_open(e));
+		}
+		// uniforms on (0, 1) one engine word each, then a block of quantiles
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			check_engine<E>();
+
+			constexpr size_t N = 256;
+			double u[N], y[N];
+			while (n) {
+				size_t m = n < N ? n : N;
+				uniforms_open(e, m, u);
+				quantile(m, u, y);
+				for (size_t i = 0; i < m; ++i)
+					x[i] = static_cast<U>(y[i]);
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+	// standard normal quantile, AS 241 PPND16, about 16 digits
+	inline double normal_quantile(double p)
+	{
+		double q = p - 0.5;
+
+		if (std::fabs(q) <= 0.425) {
+			double r = 0.180625 - q*q;
+			return q*(((((((2.5090809287301226727e+3*r + 3.3430575583588128105e+4)*r
+				+ 6.7265770927008700853e+4)*r + 4.5921953931549871457e+4)*r
+				+ 1.3731693765509461125e+4)*r + 1.9715909503065514427e+3)*r
+				+ 1.3314166789178437745e+2)*r + 3.3871328727963666080e+0)
+				/ (((((((5.2264952788528545610e+3*r + 2.8729085735721942674e+4)*r
+				+ 3.9307895800092710610e+4)*r + 2.1213794301586595867e+4)*r
+				+ 5.3941960214247511077e+3)*r + 6.8718700749205790830e+2)*r
+				+ 4.2313330701600911252e+1)*r + 1);
+		}
+
+		double r = q < 0 ? p : 1 - p;
+		if (r <= 0)
+			return q < 0 ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+
+		r = std::sqrt(-std::log(r));
+		double x;
+		if (r <= 5) {
+			r -= 1.6;
+			x = (((((((7.74545014278341407640e-4*r + 2.27238449892691845833e-2)*r
+				+ 2.41780725177450611770e-1)*r + 1.27045825245236838258e+0)*r
+				+ 3.64784832476320460504e+0)*r + 5.76949722146069140550e+0)*r
+				+ 4.63033784615654529590e+0)*r + 1.42343711074968357734e+0)
+				/ (((((((1.05075007164441684324e-9*r + 5.47593808499534494600e-4)*r
+				+ 1.51986665636164571966e-2)*r + 1.48103976427480074590e-1)*r
+				+ 6.89767334985100004550e-1)*r + 1.67638483018380384940e+0)*r
+				+ 2.05319162663775882187e+0)*r + 1);
+		}
+		else {
+			r -= 5;
+			x = (((((((2.01033439929228813265e-7*r + 2.71155556874348757815e-5)*r
+				+ 1.24266094738807843860e-3)*r + 2.65321895265761230930e-2)*r
+				+ 2.96560571828504891230e-1)*r + 1.78482653991729133580e+0)*r
+				+ 5.46378491116411436990e+0)*r + 6.65790464350110377720e+0)
+				/ (((((((2.04426310338993978564e-15*r + 1.42151175831644588870e-7)*r
+				+ 1.84631831751005468180e-5)*r + 7.86869131145613259100e-4)*r
+				+ 1.48753612908506148525e-2)*r + 1.36929880922735805310e-1)*r
+				+ 5.99832206555887937690e-1)*r + 1);
+		}
+
+		return q < 0 ? -x : x;
+	}
+
+	// constants of gamma_quantile that depend only on the shape
+	struct gamma_shape {
+		double a, gln;  // shape and lgamma(a)
+		double c, s;    // Wilson-Hilferty 1 - 1/(9a) and 1/(3 sqrt(a)) for a > 1
+		double t, ia;   // small shape split and 1/a for a <= 1
+
+		explicit gamma_shape(double a)
+			: a(a), gln(std::lgamma(a)), c(1 - 1/(9*a)), s(1/(3*std::sqrt(a))),
+			  t(1 - a*(0.253 + a*0.12)), ia(1/a)
+		{ }
+	};
+
+	// P(a, x) = p by Halley's method from the Wilson-Hilferty or small shape guess
+	inline double gamma_quantile(const gamma_shape& g, double p)
+	{
+		const double a = g.a;
+
+		if (p <= 0)
+			return 0;
+		if (p >= 1)
+			return std::numeric_limits<double>::infinity();
+
+		double x;
+		if (a > 1) {
+			double w = g.c + normal_quantile(p)*g.s;
+			x = a*w*w*w;
+			if (x < 1e-3)
+				x = 1e-3;
+		}
+		else {
+			x = p < g.t ? std::pow(p/g.t, g.ia) : 1 - std::log1p(-(p - g.t)/(1 - g.t));
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			if (x <= 0)
+				return 0;
+			double err = gamma_p(a, x, g.gln) - p;
+			double f = std::exp((a - 1)*std::log(x) - x - g.gln);
+			if (f == 0)
+				break;
+			double u = err/f;
+			double d = u/(1 - 0.5*(std::min)(1., u*((a - 1)/x - 1)));
+			x -= d;
+			if (x <= 0)
+				x = 0.5*(x + d);
+			// Halley is cubic, the error after a step of d is far below d
+			if (std::fabs(d) < 1e-6*x)
+				break;
+		}
+
+		return x;
+	}
+	inline double gamma_quantile(double a, double p)
+	{
+		return gamma_quantile(gamma_shape(a), p);
+	}
+
+	// Student t quantile by safeguarded Newton iteration in the lower tail
+	inline double student_t_quantile(double nu, double p)
+	{
+		constexpr double pi = 3.141592653589793;
+
+		if (nu == 1)
+			return p < 0.5 ? -1/std::tan(pi*p) : 1/std::tan(pi*(1 - p));
+		if (nu == 2)
+			return (2*p - 1)/std::sqrt(2*p*(1 - p));
+		if (p > 0.5)
+			return -student_t_quantile(nu, 1 - p);
+		if (p == 0.5)
+			return 0;
+		if (p <= 0)
+			return -std::numeric_limits<double>::infinity();
+
+		double lb = log_beta(nu/2, 0.5);
+		double c = std::exp(-lb)/std::sqrt(nu);
+		auto F = [nu, lb](double t) { double s = nu + t*t; return 0.5*beta_inc(nu/2, 0.5, nu/s, t*t/s, lb); };
+		auto f = [nu, c](double t) { return c*std::pow(1 + t*t/nu, -(nu + 1)/2); };
+
+		// Cornish-Fisher start, then bracket [lo, 0] with F(lo) <= p
+		double z = normal_quantile(p), z2 = z*z;
+		double x = z + z*(z2 + 1)/(4*nu) + z*((5*z2 + 16)*z2 + 3)/(96*nu*nu);
+		double lo = x, hi = 0;
+		while (F(lo) > p)
+			lo *= 2;
+
+		for (int i = 0; i < 64; ++i) {
+			double err = F(x) - p;
+			if (err > 0)
+				hi = x;
+			else
+				lo = x;
+			double y = x - err/f(x);
+			if (!(y > lo && y < hi))
+				y = 0.5*(lo + hi); // bisect when Newton leaves the bracket
+			if (std::fabs(y - x) <= 1e-14*std::fabs(x))
+				return y;
+			x = y;
+		}
+
+		return x;
+	}
+
+	class normal : public base<normal> {
+		double mu_, sigma_;
+	public:
+		explicit normal(double mu = 0, double sigma = 1)
+			: mu_(mu), sigma_(sigma)
+		{
+			if (!(sigma > 0))
+				throw std::invalid_argument("distribution::inverse::normal: sigma must be positive");
+		}
+		double q(double u) const
+		{
+			return mu_ + sigma_*normal_quantile(u);
+		}
+	};
+
+	class exponential : public base<exponential> {
+		double lambda_;
+	public:
+		explicit exponential(double lambda = 1, double = 0)
+			: lambda_(lambda)
+		{
+			if (!(lambda > 0))
+				throw std::invalid_argument("distribution::inverse::exponential: lambda must be positive");
+		}
+		double q(double u) const
+		{
+			return -std::log1p(-u)/lambda_;
+		}
+	};
+
+	// shape a and scale b as std::weibull_distribution
+	class weibull : public base<weibull> {
+		double a_, b_;
+	public:
+		explicit weibull(double a = 1, double b = 1)
+			: a_(a), b_(b)
+		{
+			if (!(a > 0 && b > 0))
+				throw std::invalid_argument("distribution::inverse::weibull: a and b must be positive");
+		}
+		double q(double u) const
+		{
+			return b_*std::pow(-std::log1p(-u), 1/a_);
+		}
+	};
+
+	class cauchy : public base<cauchy> {
+		double a_, b_;
+	public:
+		explicit cauchy(double a = 0, double b = 1)
+			: a_(a), b_(b)
+		{
+			if (!(b > 0))
+				throw std::invalid_argument("distribution::inverse::cauchy: b must be positive");
+		}
+		double q(double u) const
+		{
+			constexpr double pi = 3.141592653589793;
+
+			return a_ + b_*(u < 0.5 ? -1/std::tan(pi*u) : 1/std::tan(pi*(1 - u)));
+		}
+	};
+
+	// Gumbel with location a and scale b as std::extreme_value_distribution
+	class extreme_value : public base<extreme_value> {
+		double a_, b_;
+	public:
+		explicit extreme_value(double a = 0, double b = 1)
+			: a_(a), b_(b)
+		{
+			if (!(b > 0))
+				throw std::invalid_argument("distribution::inverse::extreme_value: b must be positive");
+		}
+		double q(double u) const
+		{
+			return a_ - b_*std::log(-std::log(u));
+		}
+	};
+
+	// (u^lambda - (1 - u)^lambda)/lambda, the logistic quantile for lambda = 0
+	class tukey_lambda : public base<tukey_lambda> {
+		double lambda_;
+	public:
+		explicit tukey_lambda(double lambda = 0, double = 0)
+			: lambda_(lambda)
+		{ }
+		double q(double u) const
+		{
+			return lambda_ == 0
+				? std::log(u/(1 - u))
+				: (std::pow(u, lambda_) - std::pow(1 - u, lambda_))/lambda_;
+		}
+	};
+
+	// shape alpha and scale beta as std::gamma_distribution
+	class gamma : public base<gamma> {
+		gamma_shape g_;
+		double beta_;
+	public:
+		explicit gamma(double alpha = 1, double beta = 1)
+			: g_(alpha), beta_(beta)
+		{
+			if (!(alpha > 0 && beta > 0))
+				throw std::invalid_argument("distribution::inverse::gamma: alpha and beta must be positive");
+		}
+		double q(double u) const
+		{
+			return beta_*gamma_quantile(g_, u);
+		}
+	};
+
+	class chi_squared : public base<chi_squared> {
+		gamma_shape g_;
+	public:
+		explicit chi_squared(double k = 1, double = 0)
+			: g_(k/2)
+		{
+			if (!(k > 0))
+				throw std::invalid_argument("distribution::inverse::chi_squared: k must be positive");
+		}
+		double q(double u) const
+		{
+			return 2*gamma_quantile(g_, u);
+		}
+	};
+
+	class student_t : public base<student_t> {
+		double nu_;
+	public:
+		explicit student_t(double nu = 1, double = 0)
+			: nu_(nu)
+		{
+			if (!(nu > 0))
+				throw std::invalid_argument("distribution::inverse::student_t: nu must be positive");
+		}
+		double q(double u) const
+		{
+			return student_t_quantile(nu_, u);
+		}
+	};
+
+} // namespace distribution::inverse
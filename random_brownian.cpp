@@ -14,6 +14,8 @@ static generator::seed<mt19937> s(random::default_random());
 // standard normal
 static auto normal = std::normal_distribution<double>();
 
+// see RANDOM.BROWNIAN.PATH in xllbrownian.cpp to add times without regenerating the path
+
 static AddInX xai_random_brownian(
 	FunctionX(XLL_FP, _T("?xll_random_brownian"), _T("RANDOM.BROWNIAN"))
 	.Arg(XLL_FP, _T("Times"), _T("is an array of times at which to sample Brownian motion"))
@@ -0,0 +1,273 @@
+// ranluxpp.h - RANLUX++ engine
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// RANLUX is the linear congruential generator x <- a x mod m with
+// m = 2^576 - 2^240 + 1 and a = m - (m - 1)/2^24. Skipping p = 2048 values
+// gives the highest luxury level and each step yields 576 bits of output.
+// A. Sibidanov, A revision of the subtract-with-borrow random number generators, 2017.
+#pragma once
+#include <array>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include "uniform_int.h"
+
+namespace engine {
+
+	class ranluxpp {
+	public:
+		typedef std::uint64_t result_type;
+		static constexpr size_t words = 9;
+		static constexpr std::uint64_t luxury = 2048;
+		typedef std::array<std::uint64_t, words> number;
+
+		static constexpr result_type (min)()
+		{
+			return 0;
+		}
+		static constexpr result_type (max)()
+		{
+			return ~result_type(0);
+		}
+
+		explicit ranluxpp(std::uint64_t s = default_seed)
+		{
+			seed(s);
+		}
+		// seed sequences only, so copying a non-const engine is not a reseed
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, ranluxpp>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		explicit ranluxpp(Sseq& q)
+		{
+			seed(q);
+		}
+
+		static constexpr std::uint64_t default_seed = 314159265;
+
+		// seeds are 2^96 steps of a apart
+		void seed(std::uint64_t s = default_seed)
+		{
+			static const number a96 = [] {
+				number x = a();
+				for (int i = 0; i < 96; ++i)
+					x = mulmod(x, x);
+				return x;
+			}();
+
+			x_ = powmod(a96, s);
+			i_ = words;
+		}
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, ranluxpp>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		void seed(Sseq& q)
+		{
+			std::uint32_t s[2];
+			q.generate(s, s + 2);
+			seed((static_cast<std::uint64_t>(s[1]) << 32) | s[0]);
+		}
+
+		result_type operator()()
+		{
+			if (i_ == words)
+				step();
+
+			return x_[i_++];
+		}
+		void fill(size_t n, result_type* x)
+		{
+			while (n) {
+				if (i_ == words)
+					step();
+				size_t k = words - i_ < n ? words - i_ : n;
+				for (size_t j = 0; j < k; ++j)
+					x[j] = x_[i_ + j];
+				i_ += k;
+				x += k;
+				n -= k;
+			}
+		}
+		// skip n outputs in O(log n) multiplications
+		void discard(unsigned long long n)
+		{
+			unsigned long long t = i_ + n;
+			if (t <= words) {
+				i_ = static_cast<size_t>(t);
+			}
+			else {
+				x_ = mulmod(powmod(A(), t/words), x_);
+				i_ = static_cast<size_t>(t%words);
+			}
+		}
+
+		bool operator==(const ranluxpp& r) const
+		{
+			return x_ == r.x_ && i_ == r.i_;
+		}
+		bool operator!=(const ranluxpp& r) const
+		{
+			return !operator==(r);
+		}
+
+		// x*y mod m
+		static number mulmod(const number& x, const number& y)
+		{
+			std::uint64_t p[2*words + 1] = {0};
+
+			for (size_t i = 0; i < words; ++i) {
+				std::uint64_t c = 0;
+				for (size_t j = 0; j < words; ++j) {
+					std::uint64_t lo, hi = distribution::mul128(x[i], y[j], &lo);
+					lo += c;
+					hi += lo < c;
+					p[i + j] += lo;
+					hi += p[i + j] < lo;
+					c = hi;
+				}
+				p[i + words] = c;
+			}
+
+			return reduce(p, 2*words);
+		}
+		// x^n mod m
+		static number powmod(number x, std::uint64_t n)
+		{
+			number r = one();
+
+			while (n) {
+				if (n & 1)
+					r = mulmod(r, x);
+				n >>= 1;
+				if (n)
+					x = mulmod(x, x);
+			}
+
+			return r;
+		}
+
+		static const number& m()
+		{
+			static const number m_ = {1, 0, 0, 0xFFFF000000000000, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull};
+
+			return m_;
+		}
+		// a = m - (m - 1)/2^24 = m - (2^552 - 2^216)
+		static const number& a()
+		{
+			static const number a_ = [] {
+				number d = {0, 0, 0, 0xFFFFFFFFFF000000, ~0ull, ~0ull, ~0ull, ~0ull, 0x000000FFFFFFFFFF};
+				number x = m();
+				sub(x.data(), d.data(), words);
+				return x;
+			}();
+
+			return a_;
+		}
+		// a^p
+		static const number& A()
+		{
+			static const number A_ = powmod(a(), luxury);
+
+			return A_;
+		}
+	private:
+		number x_;
+		size_t i_;
+
+		void step()
+		{
+			x_ = mulmod(A(), x_);
+			i_ = 0;
+		}
+
+		static number one()
+		{
+			number r = {1};
+
+			return r;
+		}
+		// x += y for n words, return carry
+		static std::uint64_t add(std::uint64_t* x, const std::uint64_t* y, size_t n)
+		{
+			std::uint64_t c = 0;
+			for (size_t i = 0; i < n; ++i) {
+				std::uint64_t s = x[i] + c;
+				c = s < c;
+				x[i] = s + y[i];
+				c += x[i] < s;
+			}
+
+			return c;
+		}
+		// x -= y for n words, return borrow
+		static std::uint64_t sub(std::uint64_t* x, const std::uint64_t* y, size_t n)
+		{
+			std::uint64_t b = 0;
+			for (size_t i = 0; i < n; ++i) {
+				std::uint64_t d = x[i] - b;
+				b = d > x[i];
+				b += d < y[i];
+				x[i] = d - y[i];
+			}
+
+			return b;
+		}
+		// x mod m for x of n <= 2*words words using 2^576 = 2^240 - 1 mod m
+		static number reduce(std::uint64_t* x, size_t n)
+		{
+			while (n > words && x[n - 1] == 0)
+				--n;
+
+			while (n > words) {
+				// x = L + H 2^576 = L + H 2^240 - H, 240 = 3*64 + 48
+				std::uint64_t H[words + 2];
+				size_t h = n - words;
+				for (size_t i = 0; i < h; ++i) {
+					H[i] = x[words + i];
+					x[words + i] = 0;
+				}
+				x[n] = 0;
+
+				std::uint64_t c = 0, b = 0, prev = 0;
+				size_t k = h + 4 > words ? h + 4 : words;
+				for (size_t i = 0; i <= k; ++i) {
+					// word i of H << 240
+					std::uint64_t hi = i >= 3 && i - 3 < h ? H[i - 3] : 0;
+					std::uint64_t s = (hi << 48) | (prev >> 16);
+					prev = hi;
+					std::uint64_t t = x[i] + c;
+					c = t < c;
+					t += s;
+					c += t < s;
+					// minus H
+					std::uint64_t y = i < h ? H[i] : 0;
+					std::uint64_t d = t - b;
+					b = d > t;
+					b += d < y;
+					x[i] = d - y;
+				}
+
+				n = k + 1;
+				while (n > words && x[n - 1] == 0)
+					--n;
+			}
+
+			number r;
+			for (size_t i = 0; i < words; ++i)
+				r[i] = i < n ? x[i] : 0;
+			// r < 2^576 < 2m
+			bool ge = true;
+			for (size_t i = words; i--; ) {
+				if (r[i] != m()[i]) {
+					ge = r[i] > m()[i];
+					break;
+				}
+			}
+			if (ge)
+				sub(r.data(), m().data(), words);
+
+			return r;
+		}
+	};
+
+} // namespace engine
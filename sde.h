@@ -0,0 +1,227 @@
+// sde.h - exact and quadratic exponential schemes for diffusions
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Paths are simulated in chunks of paths with state stored as arrays, one
+// block of normals or uniforms per chunk and time step.
+// L. Andersen, Efficient simulation of the Heston stochastic volatility model, 2007.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "gamma.h"
+#include "pcg.h"
+#include "quantile.h"
+
+namespace process {
+
+	// dX = kappa (theta - X) dt + sigma dW
+	class ornstein_uhlenbeck {
+		double x0_, kappa_, theta_, sigma_;
+	public:
+		static constexpr size_t dimension = 1;
+
+		ornstein_uhlenbeck(double x0, double kappa, double theta, double sigma)
+			: x0_(x0), kappa_(kappa), theta_(theta), sigma_(sigma)
+		{
+			if (kappa < 0 || sigma < 0)
+				throw std::invalid_argument("process::ornstein_uhlenbeck: kappa and sigma must be non-negative");
+		}
+		void init(size_t m, double* const* s) const
+		{
+			std::fill(s[0], s[0] + m, x0_);
+		}
+		template<class E>
+		void step(E& e, double h, size_t m, double* const* s, double* z) const
+		{
+			double a = std::exp(-kappa_*h);
+			double sd = kappa_ > 0 ? sigma_*std::sqrt(-std::expm1(-2*kappa_*h)/(2*kappa_)) : sigma_*std::sqrt(h);
+
+			distribution::inverse::normal().generate(e, m, z);
+			double* x = s[0];
+			for (size_t i = 0; i < m; ++i)
+				x[i] = theta_ + (x[i] - theta_)*a + sd*z[i];
+		}
+		double observe(const double* const* s, size_t i) const
+		{
+			return s[0][i];
+		}
+	};
+
+	// dX = kappa (theta - X) dt + sigma sqrt(X) dW, sampled from the exact
+	// scaled noncentral chi-squared transition
+	class cox_ingersoll_ross {
+		double x0_, kappa_, theta_, sigma_;
+	public:
+		static constexpr size_t dimension = 1;
+
+		cox_ingersoll_ross(double x0, double kappa, double theta, double sigma)
+			: x0_(x0), kappa_(kappa), theta_(theta), sigma_(sigma)
+		{
+			if (!(x0 >= 0 && kappa > 0 && theta > 0 && sigma > 0))
+				throw std::invalid_argument("process::cox_ingersoll_ross: x0 must be non-negative and kappa, theta, sigma positive");
+		}
+		void init(size_t m, double* const* s) const
+		{
+			std::fill(s[0], s[0] + m, x0_);
+		}
+		template<class E>
+		void step(E& e, double h, size_t m, double* const* s, double* z) const
+		{
+			double a = std::exp(-kappa_*h);
+			double c = sigma_*sigma_*(-std::expm1(-kappa_*h))/(4*kappa_);
+			double d = 4*kappa_*theta_/(sigma_*sigma_);
+			double* x = s[0];
+
+			if (d > 1) {
+				// (Z + sqrt(lambda))^2 + chi-squared(d - 1), z holds 2m values
+				distribution::inverse::normal().generate(e, m, z);
+				distribution::chi_squared(d - 1).generate(e, m, z + m);
+				for (size_t i = 0; i < m; ++i) {
+					double y = z[i] + std::sqrt(x[i]*a/c);
+					x[i] = c*(y*y + z[m + i]);
+				}
+			}
+			else {
+				// Poisson mixture of central chi-squared, chi-squared(d + 2N) = 2 gamma(d/2 + N)
+				double* k = z;
+				double* g = z + m;
+				for (size_t i = 0; i < m; ++i)
+					g[i] = x[i]*a/(2*c);
+				distribution::poisson_each(e, m, g, k);
+				for (size_t i = 0; i < m; ++i)
+					k[i] += d/2;
+				distribution::gamma_each(e, m, k, g);
+				for (size_t i = 0; i < m; ++i)
+					x[i] = 2*c*g[i];
+			}
+		}
+		double observe(const double* const* s, size_t i) const
+		{
+			return s[0][i];
+		}
+	};
+
+	// dS/S = mu dt + sqrt(V) dW, dV = kappa (theta - V) dt + sigma sqrt(V) dZ, dW dZ = rho dt
+	// using quadratic exponential steps for V and central discretization of log S
+	class heston {
+		double s0_, v0_, mu_, kappa_, theta_, sigma_, rho_;
+		static constexpr double psi_c = 1.5;
+	public:
+		static constexpr size_t dimension = 2;
+
+		heston(double s0, double v0, double mu, double kappa, double theta, double sigma, double rho)
+			: s0_(s0), v0_(v0), mu_(mu), kappa_(kappa), theta_(theta), sigma_(sigma), rho_(rho)
+		{
+			if (!(s0 > 0 && v0 >= 0 && kappa > 0 && theta > 0 && sigma > 0))
+				throw std::invalid_argument("process::heston: s0, kappa, theta, sigma must be positive and v0 non-negative");
+			if (!(rho >= -1 && rho <= 1))
+				throw std::invalid_argument("process::heston: rho must be in [-1, 1]");
+		}
+		void init(size_t m, double* const* s) const
+		{
+			std::fill(s[0], s[0] + m, std::log(s0_));
+			std::fill(s[1], s[1] + m, v0_);
+		}
+		// z holds 2m values, uniforms for V then normals for log S
+		template<class E>
+		void step(E& e, double h, size_t m, double* const* s, double* z) const
+		{
+			double a = std::exp(-kappa_*h), b = -std::expm1(-kappa_*h);
+			double s1 = sigma_*sigma_*a*b/kappa_, s2 = theta_*sigma_*sigma_*b*b/(2*kappa_);
+			double k = kappa_*rho_/sigma_ - 0.5;
+			double K0 = -rho_*kappa_*theta_*h/sigma_, K1 = 0.5*h*k - rho_/sigma_, K2 = 0.5*h*k + rho_/sigma_;
+			double K3 = 0.5*h*(1 - rho_*rho_);
+			double* x = s[0];
+			double* v = s[1];
+			double* u = z;
+			double* w = z + m;
+
+			distribution::inverse::normal().generate(e, m, w);
+			distribution::uniforms_open(e, m, u);
+
+			for (size_t i = 0; i < m; ++i) {
+				double mean = theta_ + (v[i] - theta_)*a;
+				double s2_ = v[i]*s1 + s2;
+				double psi = s2_/(mean*mean);
+				double v1;
+				if (psi <= psi_c) {
+					double c = 2/psi, b2 = c - 1 + std::sqrt(c)*std::sqrt(c - 1);
+					double y = std::sqrt(b2) + distribution::inverse::normal_quantile(u[i]);
+					v1 = mean/(1 + b2)*y*y;
+				}
+				else {
+					double p = (psi - 1)/(psi + 1), beta = (1 - p)/mean;
+					v1 = u[i] <= p ? 0 : std::log((1 - p)/(1 - u[i]))/beta;
+				}
+				x[i] += mu_*h + K0 + K1*v[i] + K2*v1 + std::sqrt(K3*(v[i] + v1))*w[i];
+				v[i] = v1;
+			}
+		}
+		double observe(const double* const* s, size_t i) const
+		{
+			return std::exp(s[0][i]);
+		}
+	};
+
+	// P paths of model M at the T increasing times t >= 0 into the rows of x,
+	// row j has every path at time t[j]. Chunk c of paths uses the PCG64 DXSM
+	// stream seed_stream(seed, c) so the result is the same for any number of threads.
+	template<class M>
+	inline void simulate(const M& model, size_t T, const double* t, size_t P, std::uint64_t seed, double* x, unsigned threads = 0)
+	{
+		constexpr size_t C = 256; // paths per chunk
+		const size_t chunks = (P + C - 1)/C;
+
+		for (size_t j = 0; j < T; ++j) {
+			if (!(t[j] >= (j ? t[j - 1] : 0)))
+				throw std::invalid_argument("process::simulate: times must be non-negative and increasing");
+		}
+		if (threads == 0)
+			threads = (std::max)(1u, std::thread::hardware_concurrency());
+		if (threads > chunks)
+			threads = static_cast<unsigned>(chunks ? chunks : 1);
+
+		std::atomic<size_t> next(0);
+		auto work = [&]() {
+			std::vector<double> buf((M::dimension + 2)*C);
+			double* s[M::dimension];
+			for (size_t k = 0; k < M::dimension; ++k)
+				s[k] = buf.data() + k*C;
+			double* z = buf.data() + M::dimension*C;
+
+			for (size_t c; (c = next++) < chunks; ) {
+				size_t p0 = c*C, m = P - p0 < C ? P - p0 : C;
+				engine::pcg64dxsm e;
+				e.seed_stream(seed, c);
+
+				model.init(m, s);
+				double t0 = 0;
+				for (size_t j = 0; j < T; ++j) {
+					if (t[j] > t0)
+						model.step(e, t[j] - t0, m, s, z);
+					t0 = t[j];
+					double* xj = x + j*P + p0;
+					for (size_t i = 0; i < m; ++i)
+						xj[i] = model.observe(s, i);
+				}
+			}
+		};
+
+		std::vector<std::thread> ts;
+		try {
+			for (unsigned i = 1; i < threads; ++i)
+				ts.emplace_back(work);
+		}
+		catch (const std::system_error&) {
+			// run on the threads we have
+		}
+		work();
+		for (auto& th : ts)
+			th.join();
+	}
+
+} // namespace process
@@ -0,0 +1,175 @@
+// special.h - normal, gamma and Student t distribution functions
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Block functions map n inputs to n outputs in a loop the compiler can unroll.
+#pragma once
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "uniform_int.h"
+
+namespace distribution {
+
+	// n standard normal variates using Box-Muller pairs
+	template<class E>
+	inline void standard_normal(E& e, size_t n, double* z)
+	{
+		constexpr double two_pi = 6.283185307179586;
+
+		for (size_t i = 0; i < n; i += 2) {
+			double r = std::sqrt(-2*std::log(uniform_open(e))), t = two_pi*uniform01(e);
+			z[i] = r*std::cos(t);
+			if (i + 1 < n)
+				z[i + 1] = r*std::sin(t);
+		}
+	}
+
+	inline double normal_cdf(double x)
+	{
+		return 0.5*std::erfc(-x*0.7071067811865476);
+	}
+	inline void normal_cdf(size_t n, const double* x, double* u)
+	{
+		for (size_t i = 0; i < n; ++i)
+			u[i] = 0.5*std::erfc(-x[i]*0.7071067811865476);
+	}
+
+	// continued fraction for the incomplete beta function by Lentz's method
+	inline double beta_cf(double a, double b, double x)
+	{
+		constexpr double tiny = 1e-300, eps = 1e-15;
+		double c = 1, d = 1 - (a + b)*x/(a + 1);
+		if (std::fabs(d) < tiny)
+			d = tiny;
+		d = 1/d;
+		double h = d;
+
+		for (int m = 1; m <= 300; ++m) {
+			double m2 = 2.*m;
+			double aa = m*(b - m)*x/((a + m2 - 1)*(a + m2));
+			d = 1 + aa*d;
+			if (std::fabs(d) < tiny)
+				d = tiny;
+			c = 1 + aa/c;
+			if (std::fabs(c) < tiny)
+				c = tiny;
+			d = 1/d;
+			h *= d*c;
+
+			aa = -(a + m)*(a + b + m)*x/((a + m2)*(a + m2 + 1));
+			d = 1 + aa*d;
+			if (std::fabs(d) < tiny)
+				d = tiny;
+			c = 1 + aa/c;
+			if (std::fabs(c) < tiny)
+				c = tiny;
+			d = 1/d;
+			double del = d*c;
+			h *= del;
+			if (std::fabs(del - 1) < eps)
+				break;
+		}
+
+		return h;
+	}
+
+	// log B(a, b)
+	inline double log_beta(double a, double b)
+	{
+		return std::lgamma(a) + std::lgamma(b) - std::lgamma(a + b);
+	}
+
+	// I_x(a, b) given y = 1 - x and lb = log B(a, b), for many x with fixed a and b
+	inline double beta_inc(double a, double b, double x, double y, double lb)
+	{
+		if (x <= 0)
+			return 0;
+		if (y <= 0)
+			return 1;
+
+		double lbt = a*std::log(x) + b*std::log(y) - lb;
+
+		return x < (a + 1)/(a + b + 2)
+			? std::exp(lbt)*beta_cf(a, b, x)/a
+			: 1 - std::exp(lbt)*beta_cf(b, a, y)/b;
+	}
+
+	// regularized incomplete beta function I_x(a, b)
+	inline double beta_inc(double a, double b, double x)
+	{
+		return beta_inc(a, b, x, 1 - x, log_beta(a, b));
+	}
+
+	// regularized lower incomplete gamma function P(a, x) given gln = lgamma(a)
+	inline double gamma_p(double a, double x, double gln)
+	{
+		constexpr double tiny = 1e-300, eps = 1e-15;
+
+		if (x <= 0)
+			return 0;
+
+		double lx = a*std::log(x) - x - gln;
+		if (x < a + 1) {
+			// series
+			double ap = a, del = 1/a, sum = del;
+			for (int n = 0; n < 500; ++n) {
+				ap += 1;
+				del *= x/ap;
+				sum += del;
+				if (std::fabs(del) < std::fabs(sum)*eps)
+					break;
+			}
+
+			return sum*std::exp(lx);
+		}
+
+		// continued fraction for Q(a, x) by Lentz's method
+		double b = x + 1 - a, c = 1/tiny, d = 1/b, h = d;
+		for (int i = 1; i < 500; ++i) {
+			double an = -i*(i - a);
+			b += 2;
+			d = an*d + b;
+			if (std::fabs(d) < tiny)
+				d = tiny;
+			c = b + an/c;
+			if (std::fabs(c) < tiny)
+				c = tiny;
+			d = 1/d;
+			double del = d*c;
+			h *= del;
+			if (std::fabs(del - 1) < eps)
+				break;
+		}
+
+		return 1 - std::exp(lx)*h;
+	}
+	// regularized lower incomplete gamma function P(a, x)
+	inline double gamma_p(double a, double x)
+	{
+		return gamma_p(a, x, std::lgamma(a));
+	}
+
+	// Student t with nu degrees of freedom, P(T <= t) = 1 - I_{nu/(nu + t^2)}(nu/2, 1/2)/2 for t > 0
+	inline double student_t_cdf(double nu, double t)
+	{
+		if (!(nu > 0))
+			throw std::invalid_argument("distribution::student_t_cdf: degrees of freedom must be positive");
+
+		double p = 0.5*beta_inc(nu/2, 0.5, nu/(nu + t*t));
+
+		return t > 0 ? 1 - p : p;
+	}
+	// log B(nu/2, 1/2) once for the block, 1 - x = t^2/(nu + t^2) without cancellation
+	inline void student_t_cdf(double nu, size_t n, const double* t, double* u)
+	{
+		if (!(nu > 0))
+			throw std::invalid_argument("distribution::student_t_cdf: degrees of freedom must be positive");
+
+		const double a = nu/2, lb = log_beta(a, 0.5);
+		for (size_t i = 0; i < n; ++i) {
+			double t2 = t[i]*t[i], s = nu + t2;
+			double p = 0.5*beta_inc(a, 0.5, nu/s, t2/s, lb);
+			u[i] = t[i] > 0 ? 1 - p : p;
+		}
+	}
+
+} // namespace distribution
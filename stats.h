@@ -0,0 +1,378 @@
+// stats.h - low overhead generation counters and timing
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Counters are kept per thread and aggregated when read. Define XLL_RANDOM_TIMING
+// to also record time stamp counter ticks, otherwise timers compile away.
+// Single engine draws are sampled, one in every timed_sample is timed and the
+// ticks are scaled up, so engine time is an estimate unless the engine fills.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef XLL_RANDOM_TIMING
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace random::stats {
+
+	// where time is spent
+	enum bucket { engine, distribution, output, buckets };
+
+	// written only by the owning thread, read by any thread
+	struct counters {
+		std::atomic<std::uint64_t> draws{0}, fills{0}, bytes{0}, ticks[buckets]{};
+
+		static void add(std::atomic<std::uint64_t>& a, std::uint64_t n)
+		{
+			a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+		void reset()
+		{
+			draws = 0;
+			fills = 0;
+			bytes = 0;
+			for (auto& t : ticks)
+				t = 0;
+		}
+	};
+
+	// aggregate over all threads
+	struct totals {
+		std::uint64_t draws = 0, fills = 0, bytes = 0, ticks[buckets] = {};
+
+		totals& operator+=(const counters& c)
+		{
+			draws += c.draws.load(std::memory_order_relaxed);
+			fills += c.fills.load(std::memory_order_relaxed);
+			bytes += c.bytes.load(std::memory_order_relaxed);
+			for (int i = 0; i < buckets; ++i)
+				ticks[i] += c.ticks[i].load(std::memory_order_relaxed);
+
+			return *this;
+		}
+	};
+
+	inline std::uint64_t ticks()
+	{
+#ifdef XLL_RANDOM_TIMING
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+#else
+		return 0;
+#endif
+	}
+
+	// ticks read by back to back calls, subtracted from sampled draws
+	inline const std::uint64_t ticks_overhead = [] {
+		std::uint64_t dt = ~std::uint64_t(0);
+		for (int i = 0; i < 64; ++i) {
+			std::uint64_t start = ticks();
+			dt = (std::min)(dt, ticks() - start);
+		}
+
+		return dt;
+	}();
+
+	// calibrate ticks against the steady clock since the add-in was loaded
+	inline const auto epoch = std::make_pair(std::chrono::steady_clock::now(), ticks());
+
+	inline double ns_per_tick()
+	{
+		auto dk = ticks() - epoch.second;
+		auto dt = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - epoch.first);
+
+		return dk ? dt.count()/dk : 0;
+	}
+
+	// per thread rows keyed by function name and handle
+	struct table {
+		std::mutex m; // insertion and erasure versus readers
+		std::unordered_map<const wchar_t*, counters> functions;
+		std::unordered_map<double, counters> handles;
+		std::vector<double> dead; // handle rows to erase when no call is in flight
+		std::atomic<int> calls{0}; // calls in flight on the owning thread
+
+		// rows of destroyed handles can only go while no call on this thread
+		// holds a pointer into handles
+		void erase(double h)
+		{
+			if (calls.load(std::memory_order_acquire) == 0)
+				handles.erase(h);
+			else
+				dead.push_back(h);
+		}
+	};
+
+	inline std::mutex registry_mutex;
+	inline std::vector<std::shared_ptr<table>> registry;
+
+	// handle of each object that has been generated from
+	inline std::mutex owners_mutex;
+	inline std::unordered_map<const void*, double> owners;
+
+	// drop the rows of the handle owning p when p is destroyed
+	inline void erase(const void* p)
+	{
+		double h;
+		{
+			std::lock_guard<std::mutex> lock(owners_mutex);
+			auto i = owners.find(p);
+			if (i == owners.end())
+				return;
+			h = i->second;
+			owners.erase(i);
+		}
+
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		for (auto& t : registry) {
+			std::lock_guard<std::mutex> lock_t(t->m);
+			t->erase(h);
+		}
+	}
+
+	// tables outlive their thread so counts are not lost
+	inline table& local()
+	{
+		thread_local std::shared_ptr<table> t = [] {
+			auto p = std::make_shared<table>();
+			std::lock_guard<std::mutex> lock(registry_mutex);
+			registry.push_back(p);
+
+			return p;
+		}();
+
+		return *t;
+	}
+
+	// the add-in function and handle being evaluated on this thread
+	class call {
+		table& t;
+		counters* f;
+		counters* h;
+		double handle;
+		bool bound;
+		call* prev;
+		static inline thread_local call* current = nullptr;
+	public:
+		call(const wchar_t* name, double handle = 0)
+			: t(local()), handle(handle), bound(false), prev(current)
+		{
+			std::lock_guard<std::mutex> lock(t.m);
+			if (t.calls.load(std::memory_order_relaxed) == 0) {
+				for (double d : t.dead)
+					t.handles.erase(d);
+				t.dead.clear();
+			}
+			t.calls.fetch_add(1, std::memory_order_relaxed);
+			f = &t.functions[name];
+			h = handle ? &t.handles[handle] : nullptr;
+			current = this;
+		}
+		call(const call&) = delete;
+		call& operator=(const call&) = delete;
+		~call()
+		{
+			current = prev;
+			t.calls.fetch_sub(1, std::memory_order_release);
+		}
+
+		// p is the object behind the handle, the first object generating wins
+		static void owner(const void* p)
+		{
+			call* c = current;
+			if (c && c->h && !c->bound) {
+				c->bound = true;
+				std::lock_guard<std::mutex> lock(owners_mutex);
+				owners[p] = c->handle;
+			}
+		}
+		static void record(std::uint64_t draws, std::uint64_t bytes)
+		{
+			if (call* c = current) {
+				for (counters* p : {c->f, c->h}) {
+					if (p) {
+						counters::add(p->draws, draws);
+						counters::add(p->fills, 1);
+						counters::add(p->bytes, bytes);
+					}
+				}
+			}
+		}
+		static void charge(bucket b, std::uint64_t dt)
+		{
+			if (call* c = current) {
+				counters::add(c->f->ticks[b], dt);
+				if (c->h)
+					counters::add(c->h->ticks[b], dt);
+			}
+		}
+	};
+
+	// count one fill of n draws writing bytes of output
+	inline void record(std::uint64_t n, std::uint64_t bytes)
+	{
+		call::record(n, bytes);
+	}
+
+	// exclusive time spent in a bucket, nested timers are subtracted
+#ifdef XLL_RANDOM_TIMING
+	class timer {
+		bucket b;
+		std::uint64_t start, child;
+		timer* parent;
+		static inline thread_local timer* current = nullptr;
+	public:
+		explicit timer(bucket b)
+			: b(b), start(ticks()), child(0), parent(current)
+		{
+			current = this;
+		}
+		timer(const timer&) = delete;
+		timer& operator=(const timer&) = delete;
+		~timer()
+		{
+			std::uint64_t dt = ticks() - start;
+			if (parent)
+				parent->child += dt;
+			call::charge(b, dt > child ? dt - child : 0);
+			current = parent;
+		}
+		// charge dt measured inside the current timer to b instead
+		static void charge(bucket b, std::uint64_t dt)
+		{
+			if (current)
+				current->child += dt;
+			call::charge(b, dt);
+		}
+	};
+#else
+	class timer {
+	public:
+		explicit timer(bucket)
+		{ }
+		static void charge(bucket, std::uint64_t)
+		{ }
+	};
+#endif
+
+	inline constexpr unsigned timed_sample = 64;
+
+	// charge draws from E to the engine bucket, fills are timed and single
+	// draws are sampled since they are cheaper than reading the counter
+	template<class E>
+	struct timed {
+		typedef typename E::result_type result_type;
+		E& e;
+#ifdef XLL_RANDOM_TIMING
+		static inline thread_local unsigned draws = 0;
+#endif
+
+		timed(E& e)
+			: e(e)
+		{
+			call::owner(&e);
+		}
+		static constexpr result_type (min)()
+		{
+			return (E::min)();
+		}
+		static constexpr result_type (max)()
+		{
+			return (E::max)();
+		}
+		result_type operator()()
+		{
+#ifdef XLL_RANDOM_TIMING
+			if (++draws == timed_sample) {
+				draws = 0;
+				std::uint64_t start = ticks();
+				result_type x = e();
+				std::uint64_t dt = ticks() - start;
+				timer::charge(engine, (dt > ticks_overhead ? dt - ticks_overhead : 0)*timed_sample);
+
+				return x;
+			}
+#endif
+			return e();
+		}
+		void fill(size_t n, result_type* x)
+			requires requires(E& e_, size_t k, result_type* p) { e_.fill(k, p); }
+		{
+			timer t(engine);
+
+			e.fill(n, x);
+		}
+	};
+
+	struct snapshot {
+		std::map<std::wstring, totals> functions;
+		std::map<double, totals> handles;
+		double ns_per_tick;
+
+		snapshot()
+			: ns_per_tick(stats::ns_per_tick())
+		{
+			std::lock_guard<std::mutex> lock(registry_mutex);
+			for (auto& t : registry) {
+				std::lock_guard<std::mutex> lock_t(t->m);
+				for (auto& [name, c] : t->functions)
+					functions[name] += c;
+				for (auto& [handle, c] : t->handles)
+					if (std::find(t->dead.begin(), t->dead.end(), handle) == t->dead.end())
+						handles[handle] += c;
+			}
+		}
+	};
+
+	// counts are approximate if other threads are generating
+	inline void reset()
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		for (auto& t : registry) {
+			std::lock_guard<std::mutex> lock_t(t->m);
+			for (auto& [name, c] : t->functions)
+				c.reset();
+			for (auto& [handle, c] : t->handles)
+				c.reset();
+		}
+	}
+
+	// tab separated rows for headless use
+	inline void dump(std::wostream& os)
+	{
+		snapshot s;
+		os.precision(17);
+		auto row = [&os,&s](const totals& t) {
+			os << L'\t' << t.draws << L'\t' << t.fills << L'\t' << t.bytes;
+			for (auto k : t.ticks)
+				os << L'\t' << static_cast<std::uint64_t>(k*s.ns_per_tick);
+			os << L'\n';
+		};
+
+		os << L"Function\tHandle\tDraws\tFills\tBytes\tEngineNs\tDistributionNs\tOutputNs\n";
+		for (const auto& [name, t] : s.functions) {
+			os << name << L'\t';
+			row(t);
+		}
+		for (const auto& [handle, t] : s.handles) {
+			os << L'\t' << handle;
+			row(t);
+		}
+	}
+
+} // namespace random::stats
@@ -0,0 +1,303 @@
+// uniform_int.h - bounded integers using Lemire's nearly divisionless method
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// Engines must produce 64 random bits per call, e.g. engine::base_engine<>.
+// See https://arxiv.org/abs/1805.10941 and https://arxiv.org/abs/2408.06213
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+namespace distribution {
+
+	// high 64 bits of x*y, low 64 bits in lo
+	inline std::uint64_t mul128(std::uint64_t x, std::uint64_t y, std::uint64_t* lo)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		std::uint64_t hi;
+		*lo = _umul128(x, y, &hi);
+
+		return hi;
+#elif defined(__SIZEOF_INT128__)
+		unsigned __int128 p = static_cast<unsigned __int128>(x)*y;
+		*lo = static_cast<std::uint64_t>(p);
+
+		return static_cast<std::uint64_t>(p >> 64);
+#else
+		std::uint64_t x0 = x & 0xFFFFFFFF, x1 = x >> 32, y0 = y & 0xFFFFFFFF, y1 = y >> 32;
+		std::uint64_t p00 = x0*y0, p01 = x0*y1, p10 = x1*y0, p11 = x1*y1;
+		std::uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+		*lo = (mid << 32) | (p00 & 0xFFFFFFFF);
+
+		return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+	}
+
+	inline void prefetch(const void* p)
+	{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+		(void)p;
+#endif
+	}
+
+	template<class E>
+	constexpr void check_engine()
+	{
+		static_assert((E::min)() == 0 && (E::max)() == (std::numeric_limits<std::uint64_t>::max)(),
+			"engine must produce 64 random bits");
+	}
+
+	// uniform on [0, s) for s > 0
+	template<class E>
+	inline std::uint64_t bounded(E& e, std::uint64_t s)
+	{
+		check_engine<E>();
+
+		std::uint64_t l, m = mul128(e(), s, &l);
+		if (l < s) {
+			std::uint64_t t = (0 - s) % s;
+			while (l < t)
+				m = mul128(e(), s, &l);
+		}
+
+		return m;
+	}
+
+	// uniform on [0, s0) and [0, s1) from one engine word when s0*s1 < 2^64
+	template<class E>
+	inline void bounded2(E& e, std::uint64_t s0, std::uint64_t s1, std::uint64_t* r0, std::uint64_t* r1)
+	{
+		check_engine<E>();
+
+		std::uint64_t l, p = s0*s1;
+		*r0 = mul128(e(), s0, &l);
+		*r1 = mul128(l, s1, &l);
+		if (l < p) {
+			std::uint64_t t = (0 - p) % p;
+			while (l < t) {
+				*r0 = mul128(e(), s0, &l);
+				*r1 = mul128(l, s1, &l);
+			}
+		}
+	}
+
+	// uniform on [0, 1) with 53 bits
+	template<class E>
+	inline double uniform01(E& e)
+	{
+		check_engine<E>();
+
+		return (e() >> 11)*0x1p-53;
+	}
+
+	// words from the engine, in bulk when it can
+	template<class E>
+	inline void words(E& e, size_t n, std::uint64_t* w)
+	{
+		if constexpr (requires(E& e_, size_t k, std::uint64_t* p) { e_.fill(k, p); })
+			e.fill(n, w);
+		else
+			for (size_t i = 0; i < n; ++i)
+				w[i] = e();
+	}
+
+	// uniform on (0, 1) from the top 52 bits of w, the half is exact so
+	// the result is never 0 or 1
+	inline double open01(std::uint64_t w)
+	{
+		return ((w >> 12) + 0.5)*0x1p-52;
+	}
+
+	// uniform on (0, 1) with 52 bits
+	template<class E>
+	inline double uniform_open(E& e)
+	{
+		check_engine<E>();
+
+		return open01(e());
+	}
+
+	// n uniforms on (0, 1), one engine word each from bulk fills
+	template<class E>
+	inline void uniforms_open(E& e, size_t n, double* u)
+	{
+		check_engine<E>();
+
+		constexpr size_t N = 256;
+		std::uint64_t w[N];
+		while (n) {
+			size_t m = n < N ? n : N;
+			words(e, m, w);
+			for (size_t i = 0; i < m; ++i)
+				u[i] = open01(w[i]);
+			u += m;
+			n -= m;
+		}
+	}
+
+	template<class T = long long>
+	class uniform_int {
+		T a_, b_;
+		std::uint64_t s_; // b - a + 1, 0 for the full 64-bit range
+	public:
+		typedef T result_type;
+
+		explicit uniform_int(T a = 0, T b = (std::numeric_limits<T>::max)())
+			: a_(a), b_(b), s_(static_cast<std::uint64_t>(b) - static_cast<std::uint64_t>(a) + 1)
+		{
+			if (b < a)
+				throw std::invalid_argument("distribution::uniform_int: b must be at least a");
+		}
+		T a() const
+		{
+			return a_;
+		}
+		T b() const
+		{
+			return b_;
+		}
+		T (min)() const
+		{
+			return a_;
+		}
+		T (max)() const
+		{
+			return b_;
+		}
+		void reset()
+		{ }
+		template<class E>
+		T operator()(E& e) const
+		{
+			return static_cast<T>(static_cast<std::uint64_t>(a_) + (s_ ? bounded(e, s_) : e()));
+		}
+		// smallest integer k with (k - a + 1)/s >= u
+		void quantile(size_t n, const double* u, double* x) const
+		{
+			const double s = s_ ? static_cast<double>(s_) : 0x1p64;
+			for (size_t i = 0; i < n; ++i) {
+				double k = std::ceil(u[i]*s) - 1;
+				x[i] = static_cast<double>(a_) + (k < 0 ? 0 : k < s - 1 ? k : s - 1);
+			}
+		}
+		// n variates into x using bulk engine fills when available
+		template<class E, class U>
+		void generate(E& e, size_t n, U* x) const
+		{
+			check_engine<E>();
+
+			constexpr size_t N = 256;
+			std::uint64_t w[N], l[N];
+			const std::uint64_t a = static_cast<std::uint64_t>(a_);
+
+			while (n) {
+				size_t m = n < N ? n : N;
+				if constexpr (requires(E& e_, size_t k, std::uint64_t* p) { e_.fill(k, p); })
+					e.fill(m, w);
+				else
+					for (size_t i = 0; i < m; ++i)
+						w[i] = e();
+
+				if (s_) {
+					for (size_t i = 0; i < m; ++i)
+						w[i] = mul128(w[i], s_, &l[i]);
+					// rare, l < s has probability s/2^64
+					for (size_t i = 0; i < m; ++i) {
+						if (l[i] < s_ && l[i] < (0 - s_) % s_)
+							w[i] = bounded(e, s_);
+					}
+				}
+				for (size_t i = 0; i < m; ++i)
+					x[i] = static_cast<U>(static_cast<T>(a + w[i]));
+
+				x += m;
+				n -= m;
+			}
+		}
+	};
+
+	// Fisher-Yates shuffle of a random access range, two indices per engine word
+	// where possible and swap targets prefetched ahead of use
+	template<class E, class I>
+	inline void shuffle(E& e, I first, I last)
+	{
+		constexpr size_t N = 256, D = 16;
+		std::uint64_t j[N];
+		std::uint64_t i = static_cast<std::uint64_t>(last - first);
+
+		if (i < 2)
+			return;
+
+		--i; // swap position i with [0, i]
+		while (i > 0) {
+			size_t k = 0;
+			while (k < N && k < i) {
+				std::uint64_t s = i - k + 1;
+				if (k + 2 <= N && k + 1 < i && s <= (std::numeric_limits<std::uint64_t>::max)()/s) {
+					bounded2(e, s, s - 1, &j[k], &j[k + 1]);
+					k += 2;
+				}
+				else {
+					j[k] = bounded(e, s);
+					k += 1;
+				}
+			}
+			for (size_t m = 0; m < k; ++m) {
+				if (m + D < k)
+					prefetch(&first[j[m + D]]);
+				using std::swap;
+				swap(first[i - m], first[j[m]]);
+			}
+			i -= k;
+		}
+	}
+
+	// k distinct integers from [0, n) in random order
+	template<class E, class U>
+	inline void sample(E& e, std::uint64_t n, size_t k, U* x)
+	{
+		if (k > n)
+			throw std::invalid_argument("distribution::sample: sample size larger than population");
+
+		if (k > n/16) {
+			// partial Fisher-Yates
+			std::vector<std::uint64_t> p(n);
+			for (std::uint64_t i = 0; i < n; ++i)
+				p[i] = i;
+			for (size_t i = 0; i < k; ++i) {
+				std::uint64_t j = i + bounded(e, n - i);
+				std::swap(p[i], p[j]);
+				x[i] = static_cast<U>(p[i]);
+			}
+		}
+		else {
+			// Floyd's algorithm then shuffle the order
+			std::unordered_set<std::uint64_t> s;
+			s.reserve(2*k);
+			std::vector<std::uint64_t> p;
+			p.reserve(k);
+			for (std::uint64_t j = n - k; j < n; ++j) {
+				std::uint64_t t = bounded(e, j + 1);
+				p.push_back(s.insert(t).second ? t : j);
+				if (p.back() == j)
+					s.insert(j);
+			}
+			shuffle(e, p.begin(), p.end());
+			for (size_t i = 0; i < k; ++i)
+				x[i] = static_cast<U>(p[i]);
+		}
+	}
+
+} // namespace distribution
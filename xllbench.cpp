@@ -0,0 +1,431 @@
+// xllbench.cpp - throughput and memory benchmarks
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include "gamma.h"
+#include "pcg.h"
+#include "quantile.h"
+#include "ranluxpp.h"
+#include "special.h"
+#include "uniform_int.h"
+#include "xoshiro.h"
+#include "xllrandom.h"
+#include <psapi.h> // after windows.h
+
+using namespace xll;
+
+#ifdef _DEBUG
+
+// seconds taken by f()
+template<class F>
+inline double benchmark_seconds(F f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto dt = std::chrono::steady_clock::now() - t0;
+
+    return std::chrono::duration<double>(dt).count();
+}
+
+static AddIn xai_random_benchmark_pool(
+    Function(XLL_LPOPER, L"?xll_random_benchmark_pool", L"RANDOM.BENCHMARK.POOL")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of handles to create. Default is 100000.")
+    .Arg(XLL_DOUBLE, L"Live", L"is the number of handles alive at any time. Default is 1000.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return mt19937 sized handles allocated per second and private bytes committed, pooled versus heap.")
+    .Documentation(LR"xyzzyx(
+Simulates a workbook rebuilding its handles: each new allocation supersedes
+the oldest of <codeInline>Live</codeInline> existing ones. The payload has the size
+and alignment of an mt19937 engine handle but is trivially constructed so only
+allocation and free are timed. The last row is the rate of seeding the engine
+itself for comparison.
+\n
+<codeInline>PrivateBytes</codeInline> is the growth in process private bytes
+while the live handles are held, so allocator headers, padding and pool slabs
+are all counted. The pool keeps its slabs after the handles are freed, so a
+second call reports little or no growth for pooled handles.
+)xyzzyx")
+);
+
+// private bytes committed by this process
+inline double benchmark_private_bytes()
+{
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    pmc.cb = sizeof(pmc);
+    ensure (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof(pmc)));
+
+    return static_cast<double>(pmc.PrivateUsage);
+}
+
+// engine sized storage with nothing to construct
+struct alignas(engine::base<std::mt19937>) benchmark_payload : public random::pooled<benchmark_payload> {
+    unsigned char state[sizeof(engine::base<std::mt19937>)];
+};
+
+LPOPER WINAPI xll_random_benchmark_pool(double count, double live)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        typedef benchmark_payload P;
+        typedef engine::base<std::mt19937> E;
+
+        size_t n = count > 0 ? static_cast<size_t>(count) : 100000;
+        size_t m = live > 0 ? static_cast<size_t>(live) : 1000;
+        std::vector<P*> h(m, nullptr);
+
+        double pooled_bytes = benchmark_private_bytes();
+        double pooled = benchmark_seconds([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                delete h[i%m];
+                h[i%m] = new P;
+                h[i%m]->state[0] = static_cast<unsigned char>(i);
+            }
+        });
+        pooled_bytes = benchmark_private_bytes() - pooled_bytes;
+        for (auto& p : h) {
+            delete p;
+            p = nullptr;
+        }
+
+        double heap_bytes = benchmark_private_bytes();
+        double heap = benchmark_seconds([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                ::delete h[i%m];
+                h[i%m] = ::new P;
+                h[i%m]->state[0] = static_cast<unsigned char>(i);
+            }
+        });
+        heap_bytes = benchmark_private_bytes() - heap_bytes;
+        for (auto& p : h)
+            ::delete p;
+
+        // seeding alone, engines constructed in place outside the allocator
+        alignas(E) unsigned char buf[sizeof(E)];
+        engine::seed s;
+        double seed = benchmark_seconds([&]() {
+            for (size_t i = 0; i < n; ++i) {
+                E* e = ::new (buf) E(s);
+                e->~E();
+            }
+        });
+
+        o = OPER(4, 3);
+        o(0, 0) = L"";
+        o(0, 1) = L"PerSecond";
+        o(0, 2) = L"PrivateBytes";
+        o(1, 0) = L"pooled";
+        o(1, 1) = n/pooled;
+        o(1, 2) = pooled_bytes;
+        o(2, 0) = L"heap";
+        o(2, 1) = n/heap;
+        o(2, 2) = heap_bytes;
+        o(3, 0) = L"seed";
+        o(3, 1) = n/seed;
+        o(3, 2) = L"";
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+static AddIn xai_random_benchmark_shuffle(
+    Function(XLL_LPOPER, L"?xll_random_benchmark_shuffle", L"RANDOM.BENCHMARK.SHUFFLE")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of elements to permute. Default is 10000000.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return elements per second and bytes per second permuted by distribution::shuffle and std::shuffle.")
+);
+LPOPER WINAPI xll_random_benchmark_shuffle(double count)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        size_t n = count > 0 ? static_cast<size_t>(count) : 10000000;
+        std::vector<double> x(n);
+        std::iota(x.begin(), x.end(), 0.);
+        engine::base<std::mt19937_64> e;
+
+        double lemire = benchmark_seconds([&]() {
+            distribution::shuffle(e, x.begin(), x.end());
+        });
+        double std_ = benchmark_seconds([&]() {
+            std::shuffle(x.begin(), x.end(), e);
+        });
+
+        o = OPER(3, 3);
+        o(0, 0) = L"";
+        o(0, 1) = L"PerSecond";
+        o(0, 2) = L"BytesPerSecond";
+        o(1, 0) = L"lemire";
+        o(1, 1) = n/lemire;
+        o(1, 2) = n*sizeof(double)/lemire;
+        o(2, 0) = L"std";
+        o(2, 1) = n/std_;
+        o(2, 2) = n*sizeof(double)/std_;
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+// 64-bit words per second from bulk fills
+template<class E>
+inline double engine_rate(size_t n)
+{
+    engine::base<E> e;
+    std::vector<std::uint64_t> x(4096);
+
+    double t = benchmark_seconds([&]() {
+        for (size_t i = 0; i < n; i += x.size())
+            e.fill(x.size(), x.data());
+    });
+
+    return n/t;
+}
+
+static AddIn xai_random_benchmark_engine(
+    Function(XLL_LPOPER, L"?xll_random_benchmark_engine", L"RANDOM.BENCHMARK.ENGINE")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of 64-bit words to generate. Default is 10000000.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return 64-bit words per second generated by each engine.")
+);
+LPOPER WINAPI xll_random_benchmark_engine(double count)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        size_t n = count > 0 ? static_cast<size_t>(count) : 10000000;
+
+        o = OPER(12, 2);
+        o(0, 0) = L"ranluxpp";
+        o(0, 1) = engine_rate<engine::ranluxpp>(n);
+        o(1, 0) = L"ranlux24";
+        o(1, 1) = engine_rate<std::ranlux24>(n);
+        o(2, 0) = L"ranlux48";
+        o(2, 1) = engine_rate<std::ranlux48>(n);
+        o(3, 0) = L"mt19937";
+        o(3, 1) = engine_rate<std::mt19937>(n);
+        o(4, 0) = L"mt19937_64";
+        o(4, 1) = engine_rate<std::mt19937_64>(n);
+        o(5, 0) = L"minstd_rand";
+        o(5, 1) = engine_rate<std::minstd_rand>(n);
+        o(6, 0) = L"xoshiro256pp";
+        o(6, 1) = engine_rate<engine::xoshiro256pp>(n);
+        o(7, 0) = L"xoshiro256ss";
+        o(7, 1) = engine_rate<engine::xoshiro256ss>(n);
+        o(8, 0) = L"xoshiro256pp_x4";
+        o(8, 1) = engine_rate<engine::xoshiro256pp_x4>(n);
+        o(9, 0) = L"xoshiro256pp_x8";
+        o(9, 1) = engine_rate<engine::xoshiro256pp_x8>(n);
+        o(10, 0) = L"pcg64dxsm";
+        o(10, 1) = engine_rate<engine::pcg64dxsm>(n);
+        o(11, 0) = L"pcg64dxsm_x4";
+        o(11, 1) = engine_rate<engine::pcg64dxsm_x4>(n);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+static AddIn xai_random_benchmark_quantile(
+    Function(XLL_LPOPER, L"?xll_random_benchmark_quantile", L"RANDOM.BENCHMARK.QUANTILE")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of variates for each shape. Default is 1000000.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return gamma variates per second by inversion and by std::gamma_distribution for shapes from 0.1 to 1000.")
+    .Documentation(LR"xyzzyx(
+Columns are the shape, variates per second from the inverse distribution function,
+variates per second from <codeInline>std::gamma_distribution</codeInline> and the largest
+relative error <codeInline>|P(a, Q(a, p)) - p|/p</codeInline> over a grid of probabilities.
+)xyzzyx")
+);
+LPOPER WINAPI xll_random_benchmark_quantile(double count)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        size_t n = count > 0 ? static_cast<size_t>(count) : 1000000;
+        const double shape[] = { 0.1, 0.5, 1, 2.5, 10, 100, 1000 };
+        const size_t k = sizeof(shape)/sizeof(*shape);
+        engine::base<engine::xoshiro256pp> e;
+        std::vector<double> x(n);
+
+        o = OPER(k + 1, 4);
+        o(0, 0) = L"Shape";
+        o(0, 1) = L"Inverse";
+        o(0, 2) = L"std";
+        o(0, 3) = L"Error";
+        for (size_t i = 0; i < k; ++i) {
+            double a = shape[i];
+            double inv = benchmark_seconds([&]() {
+                distribution::inverse::gamma(a).generate(e, n, x.data());
+            });
+            double std_ = benchmark_seconds([&]() {
+                std::gamma_distribution<double> g(a);
+                for (size_t j = 0; j < n; ++j)
+                    x[j] = g(e);
+            });
+            double err = 0;
+            for (int j = 1; j < 1000; ++j) {
+                double p = j/1000.;
+                double q = distribution::inverse::gamma_quantile(a, p);
+                err = (std::max)(err, std::fabs(distribution::gamma_p(a, q) - p)/p);
+            }
+            o(i + 1, 0) = a;
+            o(i + 1, 1) = n/inv;
+            o(i + 1, 2) = n/std_;
+            o(i + 1, 3) = err;
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+// sqrt(n) times the Kolmogorov-Smirnov distance of x from cdf, about 1.36 at 5%
+template<class F>
+inline double benchmark_ks(std::vector<double>& x, F cdf)
+{
+    std::sort(x.begin(), x.end());
+    double d = 0, n = static_cast<double>(x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+        double f = cdf(x[i]);
+        d = (std::max)(d, (std::max)(f - i/n, (i + 1)/n - f));
+    }
+
+    return d*std::sqrt(n);
+}
+
+static AddIn xai_random_benchmark_gamma(
+    Function(XLL_LPOPER, L"?xll_random_benchmark_gamma", L"RANDOM.BENCHMARK.GAMMA")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of variates for each shape. Default is 1000000.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return variates per second and Kolmogorov-Smirnov statistics for gamma shapes from 0.1 to 1000.")
+    .Documentation(LR"xyzzyx(
+Columns are the shape, variates per second from blocked Marsaglia-Tsang,
+variates per second from <codeInline>std::gamma_distribution</codeInline>
+and sqrt(n) times the Kolmogorov-Smirnov distance of the blocked sample from
+the exact distribution. The last row compares the ziggurat normal with
+<codeInline>std::normal_distribution</codeInline>.
+)xyzzyx")
+);
+LPOPER WINAPI xll_random_benchmark_gamma(double count)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        size_t n = count > 0 ? static_cast<size_t>(count) : 1000000;
+        const double shape[] = { 0.1, 0.5, 1, 2.5, 10, 100, 1000 };
+        const size_t k = sizeof(shape)/sizeof(*shape);
+        engine::base<engine::xoshiro256pp> e;
+        std::vector<double> x(n);
+
+        o = OPER(k + 2, 4);
+        o(0, 0) = L"Shape";
+        o(0, 1) = L"Marsaglia-Tsang";
+        o(0, 2) = L"std";
+        o(0, 3) = L"KS";
+        for (size_t i = 0; i < k; ++i) {
+            double a = shape[i];
+            double mt = benchmark_seconds([&]() {
+                distribution::gamma(a).generate(e, n, x.data());
+            });
+            double std_ = benchmark_seconds([&]() {
+                std::gamma_distribution<double> g(a);
+                for (size_t j = 0; j < n; ++j)
+                    x[j] = g(e);
+            });
+            distribution::gamma(a).generate(e, n, x.data());
+            o(i + 1, 0) = a;
+            o(i + 1, 1) = n/mt;
+            o(i + 1, 2) = n/std_;
+            o(i + 1, 3) = benchmark_ks(x, [a](double t) { return distribution::gamma_p(a, t); });
+        }
+
+        double zig = benchmark_seconds([&]() {
+            distribution::ziggurat().generate(e, n, x.data());
+        });
+        double std_ = benchmark_seconds([&]() {
+            std::normal_distribution<double> g;
+            for (size_t j = 0; j < n; ++j)
+                x[j] = g(e);
+        });
+        distribution::ziggurat().generate(e, n, x.data());
+        o(k + 1, 0) = L"normal";
+        o(k + 1, 1) = n/zig;
+        o(k + 1, 2) = n/std_;
+        o(k + 1, 3) = benchmark_ks(x, [](double t) { return distribution::normal_cdf(t); });
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+// freed slots are reused first and the footprint counts live objects
+int xll_test_random_pool(void)
+{
+    try {
+        struct payload : public random::pooled<payload> {
+            double x[3];
+        };
+        auto used = []() {
+            for (const auto& f : random::pool_base::reports()) {
+                if (std::strcmp(f.type, typeid(payload).name()) == 0) {
+                    return f.used;
+                }
+            }
+            return size_t(0);
+        };
+
+        auto p = new payload;
+        auto q = new payload;
+        ensure (reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+        ensure (used() == 2);
+        delete p;
+        ensure (used() == 1);
+        auto r = new payload;
+        ensure (r == p);
+        delete q;
+        delete r;
+        ensure (used() == 0);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_random_pool(xll_test_random_pool);
+
+#endif // _DEBUG
@@ -0,0 +1,121 @@
+// xllbernoulli.cpp - bit parallel Bernoulli and binomial variates
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "bernoulli.h"
+#include "xllrandom.h"
+
+using namespace xll;
+
+static AddIn xai_bernoulli_distribution(
+    Function(XLL_HANDLE, L"?xll_bernoulli_distribution", L"RANDOM.BERNOULLI.DISTRIBUTION")
+    .Arg(XLL_DOUBLE, L"p", L"is the probability of 1.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to indicators that are 1 with probability p and 0 with probability 1 - p.")
+    .Documentation(LR"xyzzyx(
+Generates 64 indicators at a time by comparing the bits of engine words
+against the binary expansion of p. Probabilities of the form k/2<superscript>d</superscript>
+are exact and use at most d engine words per 64 indicators.
+Use <codeInline>RANDOM.VARIATE</codeInline> to fill a range.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_bernoulli_distribution(double p, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        typedef random::bulk_variate<distribution::bernoulli_bits> V;
+        handle<random::variate> h(new V(distribution::bernoulli_bits(p), random::engine_handle(e)));
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_binomial_distribution(
+    Function(XLL_HANDLE, L"?xll_binomial_distribution", L"RANDOM.BINOMIAL.DISTRIBUTION")
+    .Arg(XLL_DOUBLE, L"t", L"is the number of trials.")
+    .Arg(XLL_DOUBLE, L"p", L"is the probability of success on each trial.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to the number of successes in t trials with probability p.")
+    .Documentation(LR"xyzzyx(
+Uses inversion when the mean is small, counts bits of Bernoulli masks when
+t is at most 64, and Hormann's BTRD algorithm otherwise.
+Use <codeInline>RANDOM.VARIATE</codeInline> to fill a range.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_binomial_distribution(double t, double p, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        ensure (t >= 0);
+
+        typedef random::bulk_variate<distribution::binomial<long long>> V;
+        handle<random::variate> h(new V(distribution::binomial<long long>(static_cast<long long>(t), p),
+            random::engine_handle(e)));
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+#ifdef _DEBUG
+
+// sample moments of every branch within 5 standard errors
+int xll_test_binomial(void)
+{
+    try {
+        engine::base<std::mt19937_64> e;
+        const size_t n = 100000;
+        std::vector<double> x(n);
+        auto moments = [&x](double& m, double& v) {
+            m = 0;
+            for (double xi : x) m += xi;
+            m /= x.size();
+            v = 0;
+            for (double xi : x) v += (xi - m)*(xi - m);
+            v /= x.size() - 1;
+        };
+        double m, v;
+
+        for (double p : {0.25, 0.3}) {
+            distribution::bernoulli_bits b(p);
+            b.generate(e, n, x.data());
+            moments(m, v);
+            ensure (std::fabs(m - p) < 5*std::sqrt(p*(1 - p)/n));
+        }
+
+        // bits, inversion, BTRD and BTRD for p > 1/2
+        for (auto [t, p] : {std::pair(40ll, 0.3), std::pair(1000ll, 0.002), std::pair(1000ll, 0.4), std::pair(1000ll, 0.9)}) {
+            distribution::binomial<long long> b(t, p);
+            b.generate(e, n, x.data());
+            moments(m, v);
+            double var = t*p*(1 - p);
+            ensure (std::fabs(m - t*p) < 5*std::sqrt(var/n));
+            ensure (std::fabs(v/var - 1) < 0.05);
+            ensure (*std::min_element(x.begin(), x.end()) >= 0);
+            ensure (*std::max_element(x.begin(), x.end()) <= t);
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_binomial(xll_test_binomial);
+
+#endif // _DEBUG
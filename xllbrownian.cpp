@@ -0,0 +1,164 @@
+// xllbrownian.cpp - cached Brownian paths
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "brownian.h"
+
+using namespace xll;
+
+namespace random {
+
+    // owns an engine split from the engine handle so the cached path does
+    // not depend on that handle staying alive
+    struct brownian_path : public pooled<brownian_path> {
+        process::brownian_path w;
+        double mu, sigma;
+        std::unique_ptr<engine::base_engine<>> r;
+        brownian_path(double mu, double sigma, std::unique_ptr<engine::base_engine<>> r)
+            : mu(mu), sigma(sigma), r(std::move(r))
+        { }
+        ~brownian_path()
+        {
+            stats::erase(this);
+        }
+    };
+
+} // namespace random
+
+static AddIn xai_brownian_path(
+    Function(XLL_HANDLE, L"?xll_brownian_path", L"RANDOM.BROWNIAN.PATH")
+    .Arg(XLL_DOUBLE, L"?Mu", L"is the drift rate of the Brownian motion. Default is 0.")
+    .Arg(XLL_DOUBLE, L"?Sigma", L"is the standard deviation at time 1. Default is 1.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a handle to a Brownian path that keeps its samples as times are added.")
+    .Documentation(LR"xyzzyx(
+The path is <codeInline>Mu t + Sigma W(t)</codeInline> where <codeInline>W</codeInline> is standard
+Brownian motion with <codeInline>W(0) = 0</codeInline>. Unlike <codeInline>RANDOM.BROWNIAN</codeInline>,
+adding times with <codeInline>RANDOM.BROWNIAN.PATH.SAMPLE</codeInline> does not regenerate the path.
+A time between two samples is drawn from the Brownian bridge between them and a time after the
+last sample is drawn by a forward increment, so existing samples keep their values and
+each new time costs one normal draw.
+\n
+The path draws from its own engine, split from <codeInline>Engine</codeInline> when
+the handle is created, so <codeInline>Engine</codeInline> can be recalculated or deleted.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_brownian_path(double mu, double sigma, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        if (sigma == 0) {
+            sigma = 1;
+        }
+        handle<random::brownian_path> h(new random::brownian_path(mu, sigma, engine::split(random::engine_handle(e))));
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_brownian_path_sample(
+    Function(XLL_FP, L"?xll_brownian_path_sample", L"RANDOM.BROWNIAN.PATH.SAMPLE")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.BROWNIAN.PATH.")
+    .Arg(XLL_FP, L"Times", L"is an array of non-negative times.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the path at Times, sampling only the times not seen before.")
+);
+_FP12* WINAPI xll_brownian_path_sample(HANDLEX h, _FP12* pt)
+{
+#pragma XLLEXPORT
+    static FPX result;
+
+    try {
+        random::stats::call call(L"RANDOM.BROWNIAN.PATH.SAMPLE", h);
+        handle<random::brownian_path> p(h);
+        ensure (p);
+        random::stats::call::owner(p.ptr());
+
+        const size_t n = size(*pt);
+        size_t m = p->w.size();
+        {
+            random::stats::timer t(random::stats::distribution);
+            random::stats::timed<engine::base_engine<>> r_(*p->r);
+            p->w.refine(r_, n, pt->array);
+        }
+        m = p->w.size() - m;
+        random::stats::record(m, m*sizeof(double));
+
+        result.resize(pt->rows, pt->columns);
+        p->w.value(n, pt->array, result.begin());
+        for (size_t i = 0; i < n; ++i) {
+            result[i] = p->mu*pt->array[i] + p->sigma*result[i];
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return result.get();
+}
+
+#ifdef _DEBUG
+
+int xll_test_brownian(void)
+{
+    try {
+        engine::base<std::mt19937_64> e;
+        process::brownian_path p;
+        const double t0[] = {2, 1, 1}, t1[] = {0.5, 1.5, 3, 2};
+        double w0[2], w1[2];
+
+        p.refine(e, 3, t0);
+        ensure (p.size() == 3);
+        p.value(2, t0, w0);
+        p.refine(e, 4, t1);
+        ensure (p.size() == 6);
+        ensure (std::is_sorted(p.times().begin(), p.times().end()));
+        p.value(2, t0, w1);
+        ensure (w0[0] == w1[0] && w0[1] == w1[1]); // samples are kept
+
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        bool thrown = false;
+        try {
+            p.refine(e, 1, &nan);
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        ensure (thrown);
+
+        // the bridge at 1/2 between 0 and 1 added after W(1)
+        const size_t n = 100000;
+        const double t[] = {0.5, 1};
+        double v = 0, c = 0;
+        for (size_t i = 0; i < n; ++i) {
+            p.reset();
+            p.refine(e, 1, t + 1);
+            p.refine(e, 1, t);
+            double w[2];
+            p.value(2, t, w);
+            v += w[0]*w[0];
+            c += w[0]*w[1];
+        }
+        ensure (std::fabs(v/n - 0.5) < 0.02);
+        ensure (std::fabs(c/n - 0.5) < 0.02);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_brownian(xll_test_brownian);
+
+#endif // _DEBUG
@@ -0,0 +1,270 @@
+// xllcopula.cpp - joint distributions from copulas and marginals
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "copula.h"
+
+using namespace xll;
+
+namespace random {
+
+    // Copula uniforms mapped through the quantile functions of the marginals.
+    // Each marginal is called once per block of samples. Variates are the
+    // samples in row major order. Marginals are copies so the copula does not
+    // depend on their handles.
+    class copula_variate : public variate, public pooled<copula_variate> {
+        distribution::copula c;
+        engine::base_engine<>& r;
+        std::vector<std::unique_ptr<variate>> m; // null for uniform marginals
+        std::vector<double> col, buf;
+        size_t i_; // next value in buf
+    public:
+        copula_variate(const distribution::copula& c, engine::base_engine<>& r, const std::vector<const variate*>& m)
+            : c(c), r(r), m(m.size()), i_(0)
+        {
+            for (size_t j = 0; j < m.size(); ++j) {
+                if (m[j]) {
+                    this->m[j].reset(m[j]->clone(r));
+                }
+            }
+        }
+        variate* clone(engine::base_engine<>& r_) const override
+        {
+            std::vector<const variate*> m_(m.size());
+            for (size_t j = 0; j < m.size(); ++j) {
+                m_[j] = m[j].get();
+            }
+
+            return new copula_variate(c, r_, m_);
+        }
+        size_t dimension() const
+        {
+            return c.dimension();
+        }
+        // n samples of dimension() values into x
+        void sample(size_t n, double* x)
+        {
+            const size_t d = c.dimension();
+
+            {
+                stats::timer t(stats::distribution);
+                stats::timed<engine::base_engine<>> r_(r);
+                c.generate(r_, n, x);
+            }
+            col.resize(2*n);
+            for (size_t j = 0; j < d; ++j) {
+                if (!m[j]) {
+                    continue;
+                }
+                double* u = col.data();
+                double* y = u + n;
+                for (size_t i = 0; i < n; ++i) {
+                    u[i] = x[i*d + j];
+                }
+                m[j]->quantile(n, u, y);
+                for (size_t i = 0; i < n; ++i) {
+                    x[i*d + j] = y[i];
+                }
+            }
+        }
+    private:
+        // buffered samples are copied so the fork continues where this one is
+        variate* _fork() override
+        {
+            auto e = engine::fork(r);
+            std::vector<const variate*> m_(m.size());
+            for (size_t j = 0; j < m.size(); ++j) {
+                m_[j] = m[j].get();
+            }
+            std::unique_ptr<copula_variate> v(new copula_variate(c, *e, m_));
+            v->buf = buf;
+            v->i_ = i_;
+            v->own(std::move(e));
+
+            return v.release();
+        }
+        void _generate(size_t n, double* x) override
+        {
+            const size_t d = c.dimension();
+            const size_t rows = d < 4096 ? 4096/d : 1;
+
+            while (n) {
+                if (i_ == buf.size()) {
+                    buf.resize(rows*d);
+                    sample(rows, buf.data());
+                    i_ = 0;
+                }
+                size_t k = buf.size() - i_ < n ? buf.size() - i_ : n;
+                std::copy(buf.begin() + i_, buf.begin() + i_ + k, x);
+                i_ += k;
+                x += k;
+                n -= k;
+            }
+        }
+    };
+
+} // namespace random
+
+static AddIn xai_random_copula(
+    Function(XLL_HANDLE, L"?xll_random_copula", L"RANDOM.COPULA")
+    .Arg(XLL_FP, L"Correlation", L"is a square correlation matrix.")
+    .Arg(XLL_FP, L"?Marginals", L"is an optional array of distribution handles, one for each column of Correlation.")
+    .Arg(XLL_DOUBLE, L"?Nu", L"is the degrees of freedom of a Student t copula. Default is 0 for a Gaussian copula.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to joint samples with the given copula and marginal distributions.")
+    .Documentation(LR"xyzzyx(
+Samples are generated in blocks. Standard normals are correlated using the
+Cholesky factor of <codeInline>Correlation</codeInline>, divided by the square root of an
+independent chi-squared over <codeInline>Nu</codeInline> for the t copula,
+and mapped to uniforms by the normal or t distribution function.
+Each column of uniforms is then mapped by the quantile function of its marginal.
+Marginals must have a quantile function, for example handles returned by
+<codeInline>RANDOM.QUANTILE.DISTRIBUTION</codeInline>. Handles from
+<codeInline>RANDOM.REJECTION.DISTRIBUTION</codeInline> are rejected.
+A handle of 0, or omitting <codeInline>Marginals</codeInline>, leaves the column uniform.
+\n
+The copula keeps copies of the marginals and draws from its own engine split from
+<codeInline>Engine</codeInline> when it is created, so later changes to those handles do not affect it.
+\n
+Use <codeInline>RANDOM.COPULA.SAMPLE</codeInline> to get samples in rows.
+<codeInline>RANDOM.VARIATE</codeInline> and <codeInline>RANDOM.EXPORT</codeInline> return the samples in row major order.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_random_copula(_FP12* prho, _FP12* pm, double nu, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        const size_t d = prho->rows;
+        ensure (d == static_cast<size_t>(prho->columns));
+
+        std::vector<const random::variate*> m(d, nullptr);
+        const size_t n = size(*pm);
+        if (!(n == 1 && pm->array[0] == 0)) {
+            ensure (n == d);
+            for (size_t j = 0; j < d; ++j) {
+                if (pm->array[j]) {
+                    handle<random::variate> h(pm->array[j]);
+                    ensure (h);
+                    if (!h->has_quantile()) {
+                        throw std::runtime_error("RANDOM.COPULA: marginal distribution has no quantile function");
+                    }
+                    m[j] = h.ptr();
+                }
+            }
+        }
+
+        auto r = engine::split(random::engine_handle(e));
+        auto pc = new random::copula_variate(distribution::copula(d, prho->array, nu), *r, m);
+        pc->own(std::move(r));
+        handle<random::variate> h(pc);
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_copula_sample(
+    Function(XLL_FP, L"?xll_random_copula_sample", L"RANDOM.COPULA.SAMPLE")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.COPULA.")
+    .Arg(XLL_WORD, L"?Rows", L"is the number of samples. Default is 1.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return one joint sample in each row.")
+);
+_FP12* WINAPI xll_random_copula_sample(HANDLEX h, WORD n)
+{
+#pragma XLLEXPORT
+    static FPX result;
+
+    try {
+        random::stats::call call(L"RANDOM.COPULA.SAMPLE", h);
+        handle<random::variate> v(h);
+        ensure (v);
+        auto pc = dynamic_cast<random::copula_variate*>(v.ptr());
+        ensure (pc);
+        random::stats::call::owner(pc);
+        if (n == 0) {
+            n = 1;
+        }
+
+        const size_t d = pc->dimension();
+        result.resize(n, static_cast<INT32>(d));
+        random::stats::record(n*d, n*d*sizeof(double));
+        pc->sample(n, result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return result.get();
+}
+
+#ifdef _DEBUG
+
+// uniform margins and Kendall's tau = 2 asin(rho)/pi for both copulas
+int xll_test_copula(void)
+{
+    try {
+        constexpr double pi = 3.141592653589793;
+        const size_t d = 3, n = 100000, nk = 3000;
+        const double rho[] = {1, .6, .3, .6, 1, .2, .3, .2, 1};
+        engine::base<std::mt19937_64> e;
+        std::vector<double> u(n*d);
+
+        for (double nu : {0., 4.}) {
+            distribution::copula c(d, rho, nu);
+            c.generate(e, n, u.data());
+            for (size_t j = 0; j < d; ++j) {
+                double m = 0, v = 0;
+                for (size_t r = 0; r < n; ++r) {
+                    double x = u[r*d + j];
+                    ensure (0 < x && x < 1);
+                    m += x;
+                    v += x*x;
+                }
+                m /= n;
+                v = v/n - m*m;
+                ensure (std::fabs(m - 0.5) < 5*std::sqrt(1./(12*n)));
+                ensure (std::fabs(v*12 - 1) < 0.02);
+            }
+            for (auto [j, k] : {std::pair(0, 1), std::pair(0, 2), std::pair(1, 2)}) {
+                double s = 0;
+                for (size_t r = 0; r < nk; ++r) {
+                    for (size_t q = 0; q < r; ++q) {
+                        s += (u[r*d + j] - u[q*d + j])*(u[r*d + k] - u[q*d + k]) > 0 ? 1 : -1;
+                    }
+                }
+                double tau = s/(nk*(nk - 1)/2);
+                ensure (std::fabs(tau - 2*std::asin(rho[j*d + k])/pi) < 0.05);
+            }
+        }
+
+        const double bad[] = {1, .9, -.9, .9, 1, .9, -.9, .9, 1};
+        bool thrown = false;
+        try {
+            distribution::copula c(d, bad);
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        ensure (thrown);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_copula(xll_test_copula);
+
+#endif // _DEBUG
@@ -27,7 +27,9 @@ X(UNIFORM_REAL, UNPAREN(uniform_real_distribution<double>), double, UNPAREN(doub
 X(WEIBULL, UNPAREN(weibull_distribution<double>), double, UNPAREN(double,double), UNPAREN(a,b), "Density a/b (x/b)^(a-1) exp(-(x/b)^a), x > 0") \
 X(TUKEY, UNPAREN(tukey_lambda_distribution<double>), double, UNPAREN(double), UNPAREN(lambda), "Quantile (q^lambda - (1-q)^lambda)/lambda") \
 //X(UNIFORM_INT, UNPAREN(uniform_int_distribution<int>), int, UNPAREN(int,int), UNPAREN(a,b), "Uniform integers on [a,b]") \
-// illegal call of non-static member function
+// see RANDOM.UNIFORM.INT.DISTRIBUTION in xlluniform_int.cpp
+// see RANDOM.QUANTILE.DISTRIBUTION in xllquantile.cpp for one uniform per variate
+// see RANDOM.REJECTION.DISTRIBUTION in xllgamma.cpp for fast normal, gamma, chi-squared, t and F
 
 #define ENUM_(a,b,c,d,e,f) RANDOM_DISTRIBUTION_ ## a,
 enum Distribution { DISTRIBUTION(ENUM_) };
@@ -0,0 +1,143 @@
+// xllempirical.cpp - bootstrap resampling of observed data
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "empirical.h"
+
+using namespace xll;
+
+XLL_ENUM(static_cast<int>(distribution::resample::iid), RANDOM_RESAMPLE_IID, CATEGORY, L"Independent draws with replacement.")
+XLL_ENUM(static_cast<int>(distribution::resample::block), RANDOM_RESAMPLE_BLOCK, CATEGORY, L"Circular blocks of fixed length.")
+XLL_ENUM(static_cast<int>(distribution::resample::stationary), RANDOM_RESAMPLE_STATIONARY, CATEGORY, L"Circular blocks of geometric length.")
+XLL_ENUM(static_cast<int>(distribution::resample::kernel), RANDOM_RESAMPLE_KERNEL, CATEGORY, L"Independent draws smoothed by a Gaussian kernel.")
+
+typedef random::bulk_variate<distribution::empirical> empirical_variate;
+
+static AddIn xai_empirical_distribution(
+    Function(XLL_HANDLE, L"?xll_empirical_distribution", L"RANDOM.EMPIRICAL.DISTRIBUTION")
+    .Arg(XLL_FP, L"Data", L"is an array of observations.")
+    .Arg(XLL_WORD, L"?Method", L"is an optional enumeration from RANDOM_RESAMPLE_*. Default is RANDOM_RESAMPLE_IID.")
+    .Arg(XLL_DOUBLE, L"?Block", L"is the block length, or the mean block length for stationary resampling. Default is 1.")
+    .Arg(XLL_DOUBLE, L"?Bandwidth", L"is the kernel bandwidth. Default is Silverman's rule of thumb.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to draws from the empirical distribution of Data.")
+    .Documentation(LR"xyzzyx(
+The observations are copied once into contiguous memory and draws are gathered
+from random indices in batches. Block and stationary resampling keep the order of
+consecutive observations, wrapping around the end of <codeInline>Data</codeInline>,
+and are suited to time series. Kernel resampling adds Gaussian noise with the given
+bandwidth and shrinks towards the mean so the variance of the draws is the sample variance.
+Use <codeInline>RANDOM.VARIATE</codeInline> to fill a range and <codeInline>RANDOM.BOOTSTRAP</codeInline>
+for many replicates.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_empirical_distribution(_FP12* px, WORD m, double b, double h, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        ensure (m <= static_cast<WORD>(distribution::resample::kernel));
+        if (b == 0) {
+            b = 1;
+        }
+        handle<random::variate> v(new empirical_variate(distribution::empirical(
+            px->array, size(*px), static_cast<distribution::resample>(m), b, h), random::engine_handle(e)));
+        result = v.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_bootstrap(
+    Function(XLL_FP, L"?xll_random_bootstrap", L"RANDOM.BOOTSTRAP")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.EMPIRICAL.DISTRIBUTION.")
+    .Arg(XLL_WORD, L"Replicates", L"is the number of replicates.")
+    .Arg(XLL_DOUBLE, L"?Size", L"is the number of draws in each replicate. Default is the number of observations.")
+    .Arg(XLL_DOUBLE, L"?Seed", L"is an optional seed. Default is 0.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return one bootstrap replicate in each column.")
+    .Documentation(LR"xyzzyx(
+Replicates are generated in parallel. Replicate <codeInline>r</codeInline> uses its own
+PCG64 DXSM stream determined by <codeInline>Seed</codeInline> and <codeInline>r</codeInline>
+so the result does not depend on the number of threads. The engine of the
+distribution handle is not used, the same arguments always give the same
+replicates. Change <codeInline>Seed</codeInline> for new ones.
+)xyzzyx")
+);
+_FP12* WINAPI xll_random_bootstrap(HANDLEX h, WORD R, double size, double s)
+{
+#pragma XLLEXPORT
+    static FPX result;
+
+    try {
+        random::stats::call call(L"RANDOM.BOOTSTRAP", h);
+        handle<random::variate> v(h);
+        ensure (v);
+        auto pv = dynamic_cast<empirical_variate*>(v.ptr());
+        ensure (pv);
+        ensure (R > 0);
+        random::stats::call::owner(pv);
+
+        const auto& d = pv->d;
+        ensure (size >= 0);
+        size_t n = size > 0 ? static_cast<size_t>(size) : d.data().size();
+        ensure (n <= static_cast<size_t>(INT32_MAX/R));
+        result.resize(static_cast<INT32>(n), R);
+        random::stats::record(static_cast<size_t>(R)*n, static_cast<size_t>(R)*n*sizeof(double));
+        random::stats::timer t(random::stats::distribution);
+
+        distribution::bootstrap(d, static_cast<std::uint64_t>(s), R, n, result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return result.get();
+}
+
+#ifdef _DEBUG
+
+// bootstrap columns are the streams of their replicates for any number of threads
+int xll_test_bootstrap(void)
+{
+    try {
+        const size_t R = 20, n = 300; // partial task and partial row block
+        double x[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+        for (auto m : {distribution::resample::iid, distribution::resample::stationary}) {
+            distribution::empirical d(x, 10, m, 3);
+            std::vector<double> y1(n*R), y4(n*R), z(n);
+            distribution::bootstrap(d, 42, R, n, y1.data(), 1);
+            distribution::bootstrap(d, 42, R, n, y4.data(), 4);
+            ensure (y1 == y4);
+
+            for (size_t r : {0, 7, 8, 19}) {
+                distribution::empirical dr(d);
+                dr.reset();
+                engine::pcg64dxsm e;
+                e.seed_stream(42, r);
+                dr.generate(e, n, z.data());
+                for (size_t i = 0; i < n; ++i) {
+                    ensure (y1[i*R + r] == z[i]);
+                }
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_bootstrap(xll_test_bootstrap);
+
+#endif // _DEBUG
@@ -1,18 +1,25 @@
 // xllengine.cpp - rng engines
 // Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "pcg.h"
+#include "ranluxpp.h"
+#include "xoshiro.h"
 #include "xllrandom.h"
 
 #define ENGINE(X) \
-X(DEFAULT, default_random_engine, "Defaults to mt19937") \
-X(KNUTH_B, knuth_b, "Shuffle order engine based on minstd_rand0") \
-X(MINSTD_RAND, minstd_rand, "Generates a random sequence by the linear congruential algorithm.") \
-X(MINSTD_RAND0, minstd_rand0, "Generates a random sequence by the linear congruential algorithm.") \
-X(MT19937, mt19937, "Generates a high quality random sequence of integers based on the Mersenne twister algorithm.") \
-X(MT19937_64, mt19937_64, "Generates a high quality random sequence of integers based on the Mersenne twister algorithm.") \
-//X(RANLUX24, ranlux24, "Generates a random sequence using discard block and subtract-with-carry (lagged Fibonacci) algorithm.") \
-//X(RANLUX3, ranlux3, "Generates a random sequence using discard block and subtract-with-carry (lagged Fibonacci) algorithm.") \
-//X(RANLUX4, ranlux4, "Generates a random sequence using discard block and subtract-with-carry (lagged Fibonacci) algorithm.") \
-//X(RANLUX48, ranlux48, "Generates a random sequence using discard block and subtract-with-carry (lagged Fibonacci) algorithm.") \
+X(DEFAULT, std::default_random_engine, "Defaults to mt19937") \
+X(KNUTH_B, std::knuth_b, "Shuffle order engine based on minstd_rand0") \
+X(MINSTD_RAND, std::minstd_rand, "Generates a random sequence by the linear congruential algorithm.") \
+X(MINSTD_RAND0, std::minstd_rand0, "Generates a random sequence by the linear congruential algorithm.") \
+X(MT19937, std::mt19937, "Generates a high quality random sequence of integers based on the Mersenne twister algorithm.") \
+X(MT19937_64, std::mt19937_64, "Generates a high quality random sequence of integers based on the Mersenne twister algorithm.") \
+X(RANLUXPP, engine::ranluxpp, "RANLUX at the highest luxury level computed as a 576-bit linear congruential generator.") \
+X(XOSHIRO256PP, engine::xoshiro256pp, "Fast all-purpose xor/shift/rotate generator with 256 bits of state.") \
+X(XOSHIRO256SS, engine::xoshiro256ss, "Fast all-purpose xor/shift/rotate generator with the ** scrambler.") \
+X(XOSHIRO256PP_X4, engine::xoshiro256pp_x4, "Four interleaved xoshiro256++ streams 2^128 apart.") \
+X(XOSHIRO256PP_X8, engine::xoshiro256pp_x8, "Eight interleaved xoshiro256++ streams 2^128 apart.") \
+X(XOSHIRO256SS_X4, engine::xoshiro256ss_x4, "Four interleaved xoshiro256** streams 2^128 apart.") \
+X(PCG64DXSM, engine::pcg64dxsm, "Permuted congruential generator with 128-bit state and DXSM output.") \
+X(PCG64DXSM_X4, engine::pcg64dxsm_x4, "Four interleaved PCG64 DXSM streams with distinct increments.") \
 
 #define ENUM_(a,b,c) RANDOM_ENGINE_ ## a,
 enum Engine { ENGINE(ENUM_) };
@@ -22,51 +29,154 @@ ENGINE(XLL_ENUM_)
 
 using namespace xll;
 
-static AddInX xai_random_engine(
-	FunctionX(XLL_HANDLE, _T("?xll_random_engine"), _T("RANDOM.ENGINE"))
-	.Arg(XLL_USHORT, _T("Type"), _T("is an enumeration from RANDOM_ENGINE_*."))
-	.Arg(XLL_LPOPER, _T("?Seed"), _T("is an optional array of numbers to seed the Engine."))
-	.Uncalced()
-	.Category(CATEGORY)
-	.FunctionHelp(_T("Returns a handle to a random variate generator of type Engine."))
-	.Documentation(
-	)
+static AddIn xai_random_engine(
+    Function(XLL_HANDLE, L"?xll_random_engine", L"RANDOM.ENGINE")
+    .Arg(XLL_USHORT, L"Type", L"is an enumeration from RANDOM_ENGINE_*.")
+    .Arg(XLL_LPOPER, L"?Seed", L"is an optional array of numbers or a handle returned by RANDOM.SEED.SEQ.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a handle to a random number engine of type Type.")
+    .Documentation(LR"xyzzyx(
+The engine is seeded from a <codeInline>std::seed_seq</codeInline> built from
+the numbers in <codeInline>Seed</codeInline>, or from the seed sequence if
+<codeInline>Seed</codeInline> is a handle returned by
+<codeInline>RANDOM.SEED.SEQ</codeInline>. Engines producing fewer than 64 bits
+are combined so every engine returns 64 random bits per draw.
+)xyzzyx")
 );
 #pragma warning(push)
 #pragma warning(disable: 4244)
-HANDLEX WINAPI
-xll_random_engine(USHORT eng, LPOPER pseed)
+HANDLEX WINAPI xll_random_engine(USHORT eng, LPOPER pseed)
 {
 #pragma XLLEXPORT
-	handlex h;
+    handlex result;
 
-	try {
-		engine::seed ss{*pseed}, *pss{&ss};
+    try {
+        engine::seed ss(*pseed), *pss = &ss;
 
-		const OPER& s((*pseed)[0]);
-		if (pseed->size() == 1 && s.xltype == xltypeNum) {
-			handle<engine::seed> hs(s.val.num, false);
-			if (hs)
-				pss = hs;
-		}
+        if (pseed->xltype == xltypeNum) {
+            handle<engine::seed> hs(pseed->val.num);
+            if (hs) {
+                pss = hs.ptr();
+            }
+        }
 
-		switch (eng) {
+        switch (eng) {
 #define CASE_(a,b,c) case RANDOM_ENGINE_ ## a: { \
-		handle<engine::base_engine<>> he(new engine::base<std:: ## b>(*pss)); \
-		h = he.get(); break;}
-
-		ENGINE(CASE_)
-		
-		default:
-			throw std::runtime_error("RANDOM.ENGINE: unknown engine type");
-		}
-	}
-	catch (const std::exception& ex) {
-		XLL_ERROR(ex.what());
-
-		return h;
-	}
-
-	return h;
+            handle<engine::base_engine<>> he(new engine::base<b>(*pss)); \
+            result = he.get(); break; }
+
+        ENGINE(CASE_)
+#undef CASE_
+
+        default:
+            throw std::runtime_error("RANDOM.ENGINE: unknown engine type");
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
 }
 #pragma warning(pop)
+
+#ifdef _DEBUG
+
+// reference values from a big integer model of x <- a^2048 x mod m
+int xll_test_ranluxpp(void)
+{
+    try {
+        typedef engine::ranluxpp R;
+
+        // 2^24 a = 1 mod m
+        R::number b = {std::uint64_t(1) << 24};
+        ensure (R::mulmod(R::a(), b) == R::number{1});
+        // (m - 1)^2 = 1 mod m
+        R::number m1 = R::m();
+        m1[0] = 0;
+        ensure (R::mulmod(m1, m1) == R::number{1});
+
+        R r(1);
+        ensure (r() == 0xe2014da607ea03a9);
+        ensure (r() == 0x52179cde37d6fc90);
+        ensure (r() == 0x790e6e81bcb949c0);
+
+        R s;
+        s.discard(1000);
+        ensure (s() == 0x51110e7151b666dc);
+
+        // discard across and within steps equals drawing
+        R t(2), u(2);
+        for (unsigned long long n : {0, 1, 7, 9, 10, 100}) {
+            for (unsigned long long i = 0; i < n; ++i)
+                t();
+            u.discard(n);
+            ensure (t == u);
+            ensure (t() == u());
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_ranluxpp(xll_test_ranluxpp);
+
+// reference values from the published xoshiro256++ and PCG64 DXSM algorithms
+// with jumps computed as powers of the GF(2) transition matrix
+int xll_test_xoshiro_pcg(void)
+{
+    try {
+        engine::xoshiro256pp x;
+        x.state(0, {1, 2, 3, 4});
+        ensure (x() == 41943041);
+        ensure (x() == 58720359);
+        ensure (x() == 3588806011781223);
+
+        // lane 1 is lane 0 jumped 2^128 steps
+        engine::xoshiro256pp_x4 x4;
+        ensure (x4.state(0) == (std::array<std::uint64_t, 4>{
+            0x09f1fd9d03f0a9b4, 0x553274161bbf8475, 0x5d5bca4696b343b3, 0x70d29b6c7d22528d}));
+        ensure (x4.state(1) == (std::array<std::uint64_t, 4>{
+            0x7a58bf8c5ab2b568, 0xfe2c6e5958f45ede, 0x06a916fd1d0917be, 0xfff7643259548996}));
+        engine::xoshiro256pp y;
+        y.long_jump();
+        ensure (y.state(0) == (std::array<std::uint64_t, 4>{
+            0x97420010a04b0471, 0x9b517fcc199b23a3, 0x4ffd232aa62baca5, 0x0d3961ccdec2e723}));
+
+        engine::pcg64dxsm p;
+        ensure (p() == 0xa9b671852137230b);
+        ensure (p() == 0xb3ccf402a218bf42);
+        ensure (p() == 0x88995fef06e87299);
+        engine::pcg64dxsm q;
+        q.discard(1ull << 40);
+        ensure (q() == 0x1701dfcf6fbd05ca);
+
+        // discard and fill agree with drawing one at a time
+        engine::pcg64dxsm_x4 p4, q4;
+        std::uint64_t a[23], b[23];
+        for (unsigned long long n : {0, 1, 3, 4, 9, 100}) {
+            for (unsigned long long i = 0; i < n; ++i)
+                p4();
+            q4.discard(n);
+            for (auto& ai : a)
+                ai = p4();
+            q4.fill(23, b);
+            ensure (std::equal(a, a + 23, b));
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_xoshiro_pcg(xll_test_xoshiro_pcg);
+
+#endif // _DEBUG
@@ -0,0 +1,114 @@
+// xllexport.cpp - export variates beyond the worksheet grid
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "export.h"
+
+using namespace xll;
+
+static AddIn xai_random_export(
+    Function(XLL_DOUBLE, L"?xll_random_export", L"RANDOM.EXPORT")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by a RANDOM.*.DISTRIBUTION function.")
+    .Arg(XLL_DOUBLE, L"Rows", L"is the number of rows to write.")
+    .Arg(XLL_CSTRING, L"File", L"is the name of the file to write. Names ending in .npy, in any case, use NumPy format.")
+    .Arg(XLL_WORD, L"?Columns", L"is the number of values in each row. Default is 1.")
+    .Arg(XLL_DOUBLE, L"?Block", L"is the number of values generated and written at a time. Default is 65536.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Write Rows times Columns variates to File and return the number of values written.")
+    .Documentation(LR"xyzzyx(
+Values are generated in blocks and each block is written while the next
+is being generated, so memory use is two blocks no matter how many values are exported.
+\n
+Unless the file name ends in <codeInline>.npy</codeInline> the file starts with a 64 byte header:
+the 8 characters <codeInline>XLLRAND</codeInline> and a NUL, 32-bit version 1, 32-bit type 1 for float64,
+then 64-bit rows, columns and block size followed by 24 reserved bytes.
+The values follow in row major order as little-endian IEEE 754 doubles.
+)xyzzyx")
+);
+double WINAPI xll_random_export(HANDLEX rv, double rows, const wchar_t* file, WORD columns, double block)
+{
+#pragma XLLEXPORT
+    double result = std::numeric_limits<double>::quiet_NaN();
+
+    try {
+        random::stats::call call(L"RANDOM.EXPORT", rv);
+        handle<random::variate> h(rv);
+        ensure (h);
+        ensure (rows >= 0);
+        if (columns == 0) {
+            columns = 1;
+        }
+        size_t b = block > 0 ? static_cast<size_t>(block) : 1 << 16;
+        b = b < columns ? columns : b - b%columns; // whole rows per block
+
+        std::uint64_t n = static_cast<std::uint64_t>(rows)*columns;
+        std::filesystem::path path(file);
+        random::file_sink s(path);
+        if (random::is_npy(path)) {
+            s.npy_header(static_cast<std::uint64_t>(rows), columns);
+        }
+        else {
+            s.header(static_cast<std::uint64_t>(rows), columns, b/columns);
+        }
+
+        std::uint64_t done = random::stream([&h](size_t m, double* x) { h->generate(m, x); }, n, s, b);
+        s.close();
+        result = static_cast<double>(done);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+#ifdef _DEBUG
+
+int xll_test_random_export(void)
+{
+    try {
+        ensure (random::is_npy(L"a.NPY"));
+        ensure (!random::is_npy(L"a.npy.bin"));
+
+        // 3 x 2 in blocks of 4 values
+        std::filesystem::path path = std::filesystem::temp_directory_path() / L"xll_test_random_export.npy";
+        {
+            random::file_sink s(path);
+            s.npy_header(3, 2);
+            double k = 0;
+            auto n = random::stream([&k](size_t m, double* x) { while (m--) *x++ = k++; }, 6, s, 4);
+            s.close();
+            ensure (n == 6);
+        }
+
+        std::ifstream is(path, std::ios::binary);
+        char magic[8];
+        is.read(magic, 8);
+        ensure (std::memcmp(magic, "\x93NUMPY\x01\x00", 8) == 0);
+        unsigned char l[2];
+        is.read(reinterpret_cast<char*>(l), 2);
+        size_t len = l[0] + (size_t(l[1]) << 8);
+        ensure ((10 + len)%64 == 0);
+        std::string dict(len, 0);
+        is.read(dict.data(), len);
+        ensure (dict.starts_with("{'descr': '<f8', 'fortran_order': False, 'shape': (3, 2), }"));
+        ensure (dict.back() == '\n');
+        double x[7];
+        is.read(reinterpret_cast<char*>(x), sizeof(x));
+        ensure (is.gcount() == 6*sizeof(double));
+        for (int i = 0; i < 6; ++i) {
+            ensure (x[i] == i);
+        }
+        is.close();
+        std::filesystem::remove(path);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_random_export(xll_test_random_export);
+
+#endif // _DEBUG
@@ -0,0 +1,237 @@
+// xlljob.cpp - generate variates in the background
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "job.h"
+#include "quantile.h"
+#include "xoshiro.h"
+
+using namespace xll;
+
+static const wchar_t* job_status[] = {
+    L"Queued", L"Running", L"Done", L"Cancelled", L"Failed"
+};
+
+static AddIn xai_random_job(
+    Function(XLL_HANDLE, L"?xll_random_job", L"RANDOM.JOB")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by a RANDOM.*.DISTRIBUTION function.")
+    .Arg(XLL_DOUBLE, L"Count", L"is the number of variates to generate.")
+    .Arg(XLL_CSTRING, L"?File", L"is an optional file to write the variates to in the format of RANDOM.EXPORT.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a handle to a job generating Count variates on a background thread.")
+    .Documentation(LR"xyzzyx(
+The function returns immediately. Variates are generated in blocks on a thread pool
+from a copy of the distribution drawing from a copy of its engine, both in the state
+they are in when the job is submitted, so the result is the same as
+<codeInline>RANDOM.VARIATE</codeInline> on <codeInline>Handle</codeInline> would have been.
+The engine of <codeInline>Handle</codeInline> is then reseeded from its own draws so later
+variates from it do not repeat the job. <codeInline>Handle</codeInline> and its engine
+can be used, recalculated or deleted while the job runs.
+\n
+Without <codeInline>File</codeInline> the variates are kept in memory and jobs may hold at most 1 GB in total.
+Use <codeInline>RANDOM.JOB.STATUS</codeInline> to poll, <codeInline>RANDOM.JOB.CANCEL</codeInline> to stop after the
+current block, and <codeInline>RANDOM.JOB.RESULT</codeInline> to get the variates.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_random_job(HANDLEX rv, double count, const wchar_t* file)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        handle<random::variate> h(rv);
+        ensure (h);
+        ensure (count >= 0);
+
+        const std::uint64_t n = static_cast<std::uint64_t>(count);
+        std::unique_ptr<random::sink> s;
+        if (file && *file) {
+            std::filesystem::path path(file);
+            auto fs = std::make_unique<random::file_sink>(path);
+            if (random::is_npy(path)) {
+                fs->npy_header(n, 1);
+            }
+            else {
+                fs->header(n, 1, 1 << 16);
+            }
+            s = std::move(fs);
+        }
+
+        std::shared_ptr<random::variate> pv = h->fork();
+        auto g = [pv](size_t m, double* x) {
+            random::stats::call call(L"RANDOM.JOB");
+            pv->generate(m, x);
+        };
+        handle<random::job> hj(new random::job(g, n, std::move(s)));
+        result = hj.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_job_status(
+    Function(XLL_LPOPER, L"?xll_random_job_status", L"RANDOM.JOB.STATUS")
+    .Arg(XLL_HANDLE, L"Job", L"is a handle returned by RANDOM.JOB.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the status, fraction complete and number of variates generated by a job.")
+);
+LPOPER WINAPI xll_random_job_status(HANDLEX h)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        handle<random::job> j(h);
+        ensure (j);
+
+        o = OPER(1, 3);
+        o(0, 0) = job_status[static_cast<int>(j->state())];
+        o(0, 1) = j->progress();
+        o(0, 2) = static_cast<double>(j->done());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+static AddIn xai_random_job_cancel(
+    Function(XLL_BOOL, L"?xll_random_job_cancel", L"RANDOM.JOB.CANCEL")
+    .Arg(XLL_HANDLE, L"Job", L"is a handle returned by RANDOM.JOB.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Stop a job after its current block and return TRUE if it had not finished.")
+);
+BOOL WINAPI xll_random_job_cancel(HANDLEX h)
+{
+#pragma XLLEXPORT
+    try {
+        handle<random::job> j(h);
+        ensure (j);
+
+        bool running = !j->ready();
+        j->cancel();
+
+        return running;
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return FALSE;
+}
+
+static AddIn xai_random_job_result(
+    Function(XLL_LPOPER, L"?xll_random_job_result", L"RANDOM.JOB.RESULT")
+    .Arg(XLL_HANDLE, L"Job", L"is a handle returned by RANDOM.JOB.")
+    .Arg(XLL_BOOL, L"?Wait", L"is an optional boolean to wait for the job to finish. Default is FALSE.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the variates of a finished job in a column.")
+    .Documentation(LR"xyzzyx(
+Returns <codeInline>#N/A</codeInline> if the job is not done and <codeInline>Wait</codeInline> is FALSE.
+Jobs writing to a file return the number of variates written.
+)xyzzyx")
+);
+LPOPER WINAPI xll_random_job_result(HANDLEX h, BOOL wait)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        handle<random::job> j(h);
+        ensure (j);
+
+        if (!wait && !j->ready()) {
+            o = OPER();
+            o.xltype = xltypeErr;
+            o.val.err = xlerrNA;
+
+            return &o;
+        }
+
+        const auto& x = j->result();
+        if (x.size() != j->size()) {
+            o = OPER(static_cast<double>(j->done()));
+        }
+        else {
+            ensure (x.size() <= 1048576);
+            o = OPER(static_cast<int>(x.size()), 1);
+            for (size_t i = 0; i < x.size(); ++i) {
+                o[i] = x[i];
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+// restart the pool if the add-in is opened again after being closed
+int xll_random_job_open(void)
+{
+    random::job::resume_all();
+    random::thread_pool::instance().start();
+
+    return TRUE;
+}
+static Auto<Open> xao_random_job_open(xll_random_job_open);
+
+// stop running jobs so closing does not wait for them
+int xll_random_job_close(void)
+{
+    random::job::cancel_all();
+    random::thread_pool::instance().stop();
+
+    return TRUE;
+}
+static Auto<Close> xac_random_job_close(xll_random_job_close);
+
+#ifdef _DEBUG
+
+int xll_test_random_job(void)
+{
+    try {
+        typedef random::bulk_variate<distribution::inverse::normal> V;
+        const size_t n = 1000;
+        engine::base<engine::xoshiro256pp> e;
+        auto e0 = e.clone(); // state when the job is submitted
+
+        handle<random::variate> h(new V(distribution::inverse::normal(), e));
+        handlex hj = xll_random_job(h.get(), static_cast<double>(n), L"");
+        handle<random::job> j(hj);
+        ensure (j);
+        const auto& x = j->result();
+
+        // RANDOM.VARIATE from the same engine state
+        V v(distribution::inverse::normal(), *e0);
+        std::vector<double> y(n);
+        v.generate(n, y.data());
+        ensure (x == y);
+
+        // the engine of the handle does not replay the job
+        h->generate(n, y.data());
+        ensure (x != y);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_random_job(xll_test_random_job);
+
+#endif // _DEBUG
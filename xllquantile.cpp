@@ -0,0 +1,151 @@
+// xllquantile.cpp - distributions generated from one uniform per variate
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "quantile.h"
+
+#define QUANTILE(X) \
+X(NORMAL, normal, 0, 1, "Normal with mean a and standard deviation b. Default is a = 0, b = 1.") \
+X(EXPONENTIAL, exponential, 1, 0, "Exponential with rate a. Default is a = 1.") \
+X(WEIBULL, weibull, 1, 1, "Weibull with shape a and scale b. Default is a = 1, b = 1.") \
+X(CAUCHY, cauchy, 0, 1, "Cauchy with location a and scale b. Default is a = 0, b = 1.") \
+X(EXTREME_VALUE, extreme_value, 0, 1, "Gumbel with location a and scale b. Default is a = 0, b = 1.") \
+X(TUKEY_LAMBDA, tukey_lambda, 0, 0, "Tukey lambda with shape a. Default is a = 0, the logistic distribution.") \
+X(GAMMA, gamma, 1, 1, "Gamma with shape a and scale b. Default is a = 1, b = 1.") \
+X(CHI_SQUARED, chi_squared, 1, 0, "Chi-squared with a degrees of freedom. Default is a = 1.") \
+X(STUDENT_T, student_t, 1, 0, "Student t with a degrees of freedom. Default is a = 1.") \
+
+#define ENUM_(a,b,c,d,e) RANDOM_QUANTILE_ ## a,
+enum Quantile { QUANTILE(ENUM_) };
+
+#define XLL_ENUM_(a,b,c,d,e) XLL_ENUM(RANDOM_QUANTILE_##a, RANDOM_QUANTILE_##a, CATEGORY, L##e)
+QUANTILE(XLL_ENUM_)
+
+using namespace xll;
+
+static AddIn xai_quantile_distribution(
+    Function(XLL_HANDLE, L"?xll_quantile_distribution", L"RANDOM.QUANTILE.DISTRIBUTION")
+    .Arg(XLL_WORD, L"Type", L"is an enumeration from RANDOM_QUANTILE_*.")
+    .Arg(XLL_LPOPER, L"?a", L"is the first parameter of the distribution. Default depends on Type.")
+    .Arg(XLL_LPOPER, L"?b", L"is the second parameter of the distribution. Default depends on Type.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to variates generated by inverting the distribution function.")
+    .Documentation(LR"xyzzyx(
+Each variate is the quantile of exactly one uniform from the engine, so
+distributions with different types or parameters that start from the same
+engine state produce common random numbers. Bumping a parameter moves each
+variate continuously instead of reshuffling the sample.
+\n
+The normal quantile uses Wichura's AS 241 algorithm. Exponential, Weibull,
+Cauchy, extreme value and Tukey lambda quantiles are exact. Gamma and
+chi-squared quantiles are refined by Halley's method and Student t quantiles
+by safeguarded Newton iteration to near machine precision.
+Use <codeInline>RANDOM.QUANTILE</codeInline> to map a shared block of uniforms.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_quantile_distribution(WORD type, LPOPER pa, LPOPER pb, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        auto& r = random::engine_handle(e);
+
+        switch (type) {
+#define CASE_(q,c,da,db,h) case RANDOM_QUANTILE_ ## q: { \
+            typedef random::bulk_variate<distribution::inverse::c> V; \
+            handle<random::variate> hv(new V(distribution::inverse::c(random::optional(*pa, da), random::optional(*pb, db)), r)); \
+            result = hv.get(); break; }
+
+        QUANTILE(CASE_)
+#undef CASE_
+
+        default:
+            throw std::runtime_error("RANDOM.QUANTILE.DISTRIBUTION: unknown distribution type");
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_quantile(
+    Function(XLL_FP, L"?xll_random_quantile", L"RANDOM.QUANTILE")
+    .Arg(XLL_HANDLE, L"Handle", L"is a distribution handle having a quantile function.")
+    .Arg(XLL_FP, L"Probabilities", L"is an array of probabilities.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the quantiles of Probabilities with the same shape.")
+    .Documentation(LR"xyzzyx(
+Passing the same block of uniforms to several distributions, or to a
+distribution before and after bumping a parameter, gives common random numbers
+for low-noise finite differences.
+)xyzzyx")
+);
+_FP12* WINAPI xll_random_quantile(HANDLEX h, _FP12* pu)
+{
+#pragma XLLEXPORT
+    static FPX result;
+
+    try {
+        random::stats::call call(L"RANDOM.QUANTILE", h);
+        handle<random::variate> v(h);
+        ensure (v);
+
+        const size_t n = size(*pu);
+        result.resize(pu->rows, pu->columns);
+        random::stats::record(n, n*sizeof(double));
+        v->quantile(n, pu->array, result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return result.get();
+}
+
+#ifdef _DEBUG
+
+// reference values of the normal, chi-squared and t quantiles to at least 16 digits
+int xll_test_quantile(void)
+{
+    try {
+        auto near = [](double x, double y, double eps) { return std::fabs(x - y) <= eps*std::fabs(y); };
+
+        using distribution::inverse::normal_quantile;
+        ensure (normal_quantile(0.5) == 0);
+        ensure (near(normal_quantile(0.3), -0.5244005127080407, 1e-15));
+        ensure (near(normal_quantile(0.975), 1.959963984540054, 1e-15));
+        ensure (near(normal_quantile(0.025), -1.959963984540054, 1e-15));
+        ensure (near(normal_quantile(1e-10), -6.361340902404056, 1e-15));
+        ensure (near(normal_quantile(1e-20), -9.262340089798408, 1e-15));
+
+        // chi-squared with k degrees of freedom is twice gamma with shape k/2
+        using distribution::inverse::gamma_quantile;
+        ensure (near(2*gamma_quantile(0.5, 0.95), 3.841458820694124, 1e-13));
+        ensure (near(2*gamma_quantile(5, 0.95), 18.307038053275146, 1e-13));
+        ensure (near(2*gamma_quantile(1, 0.5), 2*std::log(2.), 1e-13));
+        ensure (near(2*gamma_quantile(50, 0.01), 70.0648949253998, 1e-13));
+
+        using distribution::inverse::student_t_quantile;
+        ensure (near(student_t_quantile(1, 0.975), 12.706204736174698, 1e-14));
+        ensure (near(student_t_quantile(2, 0.975), 4.302652729749464, 1e-14));
+        ensure (near(student_t_quantile(5, 0.975), 2.570581835636314, 1e-13));
+        ensure (near(student_t_quantile(10, 0.99), 2.763769458112696, 1e-13));
+        ensure (near(student_t_quantile(30, 0.025), -2.042272456301238, 1e-13));
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_quantile(xll_test_quantile);
+
+#endif // _DEBUG
@@ -78,6 +78,7 @@ LPXLOPER12 WINAPI xll_uniform_real_distribution_variate(HANDLEX urd)
     LPXLOPER12 px = 0;
 
     try {
+        random::stats::call call(L"RANDOM.UNIFORM.REAL.DISTRIBUTION.VARIATE", urd);
         handle<random::variate> h(urd);
         ensure (h);
 
@@ -90,6 +91,33 @@ LPXLOPER12 WINAPI xll_uniform_real_distribution_variate(HANDLEX urd)
     return px;
 }
 
+static AddIn xai_random_variate(
+    Function(XLL_LPXLOPER, L"?xll_random_variate", L"RANDOM.VARIATE")
+    .Arg(XLL_HANDLE, L"handle", L"is a handle returned by a RANDOM.*.DISTRIBUTION function.")
+    .Uncalced()
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Fill the calling range with variates from a distribution handle.")
+);
+LPXLOPER12 WINAPI xll_random_variate(HANDLEX rv)
+{
+#pragma XLLEXPORT
+    LPXLOPER12 px = 0;
+
+    try {
+        random::stats::call call(L"RANDOM.VARIATE", rv);
+        handle<random::variate> h(rv);
+        ensure (h);
+
+        px = variate_fill(h);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return px;
+}
+
 #if 0
 template<class T>
 T random_variate(HANDLEX d, HANDLEX e)
@@ -3,8 +3,12 @@
 // Uncomment the following line to use features for Excel2007 and above.
 //#define EXCEL12
 #pragma once
+#include <memory>
 #include <random>
 #include "xll12/xll/xll.h"
+#include "engine.h"
+#include "pool.h"
+#include "stats.h"
 
 #ifndef CATEGORY
 #define CATEGORY L"Random"
@@ -16,31 +20,195 @@ namespace random {
 
     // random engine interface
     struct variate {
+        // variates per call to _generate so every way of generating n variates
+        // from the same state gives the same values
+        static constexpr size_t block = 256;
+
+        virtual ~variate()
+        {
+            stats::erase(this);
+        }
+        // copy of the distribution drawing from r
+        virtual variate* clone(engine::base_engine<>& r) const = 0;
+        // copy owning a copy of the engine, both in their current state, so it
+        // generates the values this one would have and can be used on another
+        // thread after this handle is gone. The engine of this one is reseeded
+        // so later values from it are not the same.
+        std::unique_ptr<variate> fork()
+        {
+            return std::unique_ptr<variate>(_fork());
+        }
+        // keep e alive as long as this variate
+        template<class E>
+        void own(std::unique_ptr<E> e)
+        {
+            engine_ = std::move(e);
+        }
+        // generate n variates into x
+        void generate(size_t n, double* x)
+        {
+            stats::call::owner(this);
+            stats::record(n, n*sizeof(double));
+            while (n) {
+                size_t m = n < block ? n : block;
+                _generate(m, x);
+                x += m;
+                n -= m;
+            }
+        }
+        // true if quantile does not throw
+        virtual bool has_quantile() const
+        {
+            return false;
+        }
+        // quantiles of the n probabilities in u into x
+        void quantile(size_t n, const double* u, double* x)
+        {
+            stats::call::owner(this);
+            stats::timer t(stats::distribution);
+
+            _quantile(n, u, x);
+        }
+        // generate n variates into the cells of px
         void fill(size_t n, LPXLOPER12 px)
         {
-            _fill(n, px);
+            stats::call::owner(this);
+            stats::record(n, n*sizeof(XLOPER12));
+
+            double x[block];
+            while (n) {
+                size_t m = n < block ? n : block;
+                _generate(m, x);
+
+                stats::timer t(stats::output);
+                for (size_t i = 0; i < m; ++i) {
+                    px[i].xltype = xltypeNum;
+                    px[i].val.num = x[i];
+                }
+                px += m;
+                n -= m;
+            }
         }
     private:
-        virtual void _fill(size_t n, LPXLOPER12 px) = 0;
+        std::shared_ptr<void> engine_; // owned engine, if any
+
+        virtual void _generate(size_t n, double* x) = 0;
+        virtual variate* _fork() = 0;
+    protected:
+        virtual void _quantile(size_t, const double*, double*)
+        {
+            throw std::runtime_error("random::variate: distribution has no quantile function");
+        }
+    };
+
+    // numeric argument registered as XLL_LPOPER, or d if it is missing
+    inline double optional(const XLOPER12& o, double d)
+    {
+        if (o.xltype == xltypeMissing || o.xltype == xltypeNil) {
+            return d;
+        }
+        ensure (o.xltype == xltypeNum);
+
+        return o.val.num;
+    }
+
+    // engine from a handle returned by RANDOM.ENGINE, or a default engine if h is 0
+    inline engine::base_engine<>& engine_handle(HANDLEX h)
+    {
+        static engine::base<std::default_random_engine> e;
+
+        if (!h) {
+            return e;
+        }
+
+        xll::handle<engine::base_engine<>> he(h);
+        ensure (he);
+
+        return *he;
+    }
+
+    // variates from a distribution having a bulk generate(r, n, x)
+    template<class D, class R = engine::base_engine<>>
+    struct bulk_variate : public variate, public pooled<bulk_variate<D,R>> {
+        static constexpr bool quantile_ = requires(const D& d_, size_t n, const double* u, double* x) { d_.quantile(n, u, x); };
+        D d;
+        R& r;
+        bulk_variate(const D& d, R& r)
+            : d(d), r(r)
+        { }
+        variate* clone(engine::base_engine<>& r_) const override
+        {
+            return new bulk_variate<D>(d, r_);
+        }
+        variate* _fork() override
+        {
+            auto e = engine::fork(r);
+            std::unique_ptr<bulk_variate> v(new bulk_variate(d, *e));
+            v->own(std::move(e));
+
+            return v.release();
+        }
+        void _generate(size_t n, double* x) override
+        {
+            stats::timer t(stats::distribution);
+            stats::timed<R> r_(r);
+
+            d.generate(r_, n, x);
+        }
+        bool has_quantile() const override
+        {
+            return quantile_;
+        }
+        void _quantile(size_t n, const double* u, double* x) override
+        {
+            if constexpr (quantile_) {
+                d.quantile(n, u, x);
+            }
+            else {
+                variate::_quantile(n, u, x);
+            }
+        }
     };
 
     template<class R>
-    struct uniform_real_variate : public variate {
+    struct uniform_real_variate : public variate, public pooled<uniform_real_variate<R>> {
         std::uniform_real_distribution<double> u;
         R& r;
         uniform_real_variate(std::uniform_real_distribution<double> u, R& r)
             : u(u), r(r)
         { }
-        void _fill(size_t n, LPXLOPER12 px) override
+        variate* clone(engine::base_engine<>& r_) const override
+        {
+            return new uniform_real_variate<engine::base_engine<>>(u, r_);
+        }
+        variate* _fork() override
+        {
+            auto e = engine::fork(r);
+            std::unique_ptr<uniform_real_variate> v(new uniform_real_variate(u, *e));
+            v->own(std::move(e));
+
+            return v.release();
+        }
+        void _generate(size_t n, double* x) override
         {
+            stats::timer t(stats::distribution);
+            stats::timed<R> r_(r);
+
             while (n--) {
-                px->xltype = xltypeNum;
-                px->val.num = u(r);
-                ++px;
+                *x++ = u(r_);
+            }
+        }
+        bool has_quantile() const override
+        {
+            return true;
+        }
+        void _quantile(size_t n, const double* p, double* x) override
+        {
+            for (size_t i = 0; i < n; ++i) {
+                x[i] = u.a() + (u.b() - u.a())*p[i];
             }
         }
     };
 
 } // namespace random
 
-
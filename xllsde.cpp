@@ -0,0 +1,188 @@
+// xllsde.cpp - many paths of mean reverting and stochastic volatility models
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "xllrandom.h"
+#include "sde.h"
+
+#define SDE(X) \
+X(OU, "Ornstein-Uhlenbeck sampled exactly. Parameters: x0, kappa, theta, sigma.") \
+X(CIR, "Cox-Ingersoll-Ross sampled exactly from the noncentral chi-squared. Parameters: x0, kappa, theta, sigma.") \
+X(HESTON, "Heston stock price using Andersen's quadratic exponential scheme. Parameters: s0, v0, mu, kappa, theta, sigma, rho.") \
+
+#define ENUM_(a,b) RANDOM_SDE_ ## a,
+enum Sde { SDE(ENUM_) };
+
+#define XLL_ENUM_(a,b) XLL_ENUM(RANDOM_SDE_##a, RANDOM_SDE_##a, CATEGORY, L##b)
+SDE(XLL_ENUM_)
+
+using namespace xll;
+
+namespace random {
+
+    // paths of a model on a time grid
+    struct sde {
+        virtual ~sde()
+        {
+            stats::erase(this);
+        }
+        virtual void simulate(size_t T, const double* t, size_t P, std::uint64_t seed, double* x) const = 0;
+    };
+
+    template<class M>
+    struct sde_model : public sde, public pooled<sde_model<M>> {
+        M m;
+        sde_model(const M& m)
+            : m(m)
+        { }
+        void simulate(size_t T, const double* t, size_t P, std::uint64_t seed, double* x) const override
+        {
+            process::simulate(m, T, t, P, seed, x);
+        }
+    };
+
+} // namespace random
+
+static AddIn xai_random_sde(
+    Function(XLL_HANDLE, L"?xll_random_sde", L"RANDOM.SDE")
+    .Arg(XLL_WORD, L"Model", L"is an enumeration from RANDOM_SDE_*.")
+    .Arg(XLL_FP, L"Parameters", L"is an array of model parameters.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a handle to a stochastic differential equation model.")
+    .Documentation(LR"xyzzyx(
+Ornstein-Uhlenbeck and Cox-Ingersoll-Ross transitions are exact for any time step.
+Heston variance uses Andersen's quadratic exponential scheme and log stock price
+the central discretization of the integrated variance.
+Use <codeInline>RANDOM.SDE.PATHS</codeInline> to generate paths.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_random_sde(WORD model, _FP12* pp)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        const double* p = pp->array;
+        const size_t n = size(*pp);
+
+        random::sde* ps = nullptr;
+        switch (model) {
+        case RANDOM_SDE_OU:
+            ensure (n == 4);
+            ps = new random::sde_model<process::ornstein_uhlenbeck>(process::ornstein_uhlenbeck(p[0], p[1], p[2], p[3]));
+            break;
+        case RANDOM_SDE_CIR:
+            ensure (n == 4);
+            ps = new random::sde_model<process::cox_ingersoll_ross>(process::cox_ingersoll_ross(p[0], p[1], p[2], p[3]));
+            break;
+        case RANDOM_SDE_HESTON:
+            ensure (n == 7);
+            ps = new random::sde_model<process::heston>(process::heston(p[0], p[1], p[2], p[3], p[4], p[5], p[6]));
+            break;
+        default:
+            throw std::runtime_error("RANDOM.SDE: unknown model");
+        }
+        handle<random::sde> h(ps);
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_sde_paths(
+    Function(XLL_FP, L"?xll_random_sde_paths", L"RANDOM.SDE.PATHS")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.SDE.")
+    .Arg(XLL_FP, L"Times", L"is an increasing array of non-negative times.")
+    .Arg(XLL_WORD, L"?Paths", L"is the number of paths. Default is 1.")
+    .Arg(XLL_DOUBLE, L"?Seed", L"is an optional seed. Default is 0.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return one row for each time and one column for each path.")
+    .Documentation(LR"xyzzyx(
+Paths are simulated in parallel in chunks of 256 with the state of each chunk stored as arrays
+and one block of random numbers per chunk and time step. Each chunk uses its own PCG64 DXSM
+stream determined by <codeInline>Seed</codeInline> and the chunk so the result does not depend on the
+number of threads. The same arguments always give the same paths, change <codeInline>Seed</codeInline> for new ones.
+)xyzzyx")
+);
+_FP12* WINAPI xll_random_sde_paths(HANDLEX h, _FP12* pt, WORD P, double seed)
+{
+#pragma XLLEXPORT
+    static FPX result;
+
+    try {
+        random::stats::call call(L"RANDOM.SDE.PATHS", h);
+        handle<random::sde> s(h);
+        ensure (s);
+        random::stats::call::owner(s.ptr());
+        if (P == 0) {
+            P = 1;
+        }
+        ensure (P <= 16384);
+
+        const size_t T = size(*pt);
+        result.resize(static_cast<INT32>(T), P);
+        random::stats::record(T*P, T*P*sizeof(double));
+        random::stats::timer t(random::stats::distribution);
+
+        s->simulate(T, pt->array, P, static_cast<std::uint64_t>(seed), result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return result.get();
+}
+
+#ifdef _DEBUG
+
+// exact transition moments at t = 1 and the same paths for any number of threads
+int xll_test_sde(void)
+{
+    try {
+        const size_t P = 100000;
+        const double t[] = {0.5, 1};
+        std::vector<double> x(2*P), y(2*P);
+        auto check = [&x, P](double mean, double var) {
+            const double* x1 = x.data() + P;
+            double m = 0, v = 0;
+            for (size_t i = 0; i < P; ++i) m += x1[i];
+            m /= P;
+            for (size_t i = 0; i < P; ++i) v += (x1[i] - m)*(x1[i] - m);
+            v /= P - 1;
+            ensure (std::fabs(m - mean) < 5*std::sqrt(var/P));
+            ensure (std::fabs(v/var - 1) < 0.05);
+        };
+        const double k = 2, a = std::exp(-k);
+
+        process::ornstein_uhlenbeck ou(1, k, 0.5, 0.3);
+        process::simulate(ou, 2, t, P, 1, x.data(), 1);
+        process::simulate(ou, 2, t, P, 1, y.data(), 4);
+        ensure (x == y);
+        check(0.5 + 0.5*a, 0.09*(1 - a*a)/(2*k));
+
+        process::cox_ingersoll_ross cir(1, k, 0.5, 0.3);
+        process::simulate(cir, 2, t, P, 2, x.data());
+        check(0.5 + 0.5*a, 0.09/k*(a - a*a) + 0.5*0.09/(2*k)*(1 - a)*(1 - a));
+
+        // the stock price is a martingale after discounting, QE has a small bias
+        process::heston h(100, 0.04, 0.05, k, 0.04, 0.3, -0.7);
+        process::simulate(h, 2, t, P, 3, x.data());
+        double m = 0;
+        for (size_t i = 0; i < P; ++i) m += x[P + i];
+        ensure (std::fabs(m/P/(100*std::exp(0.05)) - 1) < 0.002);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_sde(xll_test_sde);
+
+#endif // _DEBUG
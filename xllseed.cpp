@@ -4,96 +4,98 @@
 
 using namespace xll;
 
-static AddInX xai_seed_seq(
-	FunctionX(XLL_HANDLE, _T("?xll_seed_seq"), _T("RANDOM.SEED.SEQ"))
-	.Arg(XLL_LPOPER, _T("Seed"), _T("is an array of 32-bit unsigned numbers. "))
-	.Uncalced()
-	.Category(CATEGORY)
-	.FunctionHelp(_T("Return a handle to a std::seed_seq. "))
-	.Documentation(
-		_T("This can be used as an argument to the <codeInline>RANDOM.ENGINE</codeInline> functions. ")
-	)
+static AddIn xai_seed_seq(
+    Function(XLL_HANDLE, L"?xll_seed_seq", L"RANDOM.SEED.SEQ")
+    .Arg(XLL_LPOPER, L"Seed", L"is an array of 32-bit unsigned numbers.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a handle to a std::seed_seq.")
+    .Documentation(LR"xyzzyx(
+This can be used as the <codeInline>Seed</codeInline> argument of
+<codeInline>RANDOM.ENGINE</codeInline>.
+)xyzzyx")
 );
-HANDLEX WINAPI
-xll_seed_seq(const LPOPER ps)
+HANDLEX WINAPI xll_seed_seq(LPOPER ps)
 {
-	handlex h;
 #pragma XLLEXPORT
-	try {
-		handle<engine::seed> hs(new engine::seed(*ps));
-		h = hs.get();
-	}
-	catch (const std::exception& ex) {
-		XLL_ERROR(ex.what());
-	}
-
-	return h;
+    handlex result;
+
+    try {
+        handle<engine::seed> hs(new engine::seed(*ps));
+        result = hs.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
 }
 
-static AddInX xai_seed_seq_generate(
-	FunctionX(XLL_FP, _T("?xll_seed_seq_generate"), _T("RANDOM.SEED.SEQ.GENERATE"))
-	.Arg(XLL_HANDLE, _T("Handle"), _T("is a handle returned by RANDOM.SEED.SEQ."))
-	.Arg(XLL_WORD, _T("Count"), _T("is the number of new seeds to generate. "))
-	.Category(CATEGORY)
-	.FunctionHelp(_T("Generate new seeds from old seeds. "))
-	.Documentation(
-	)
+static AddIn xai_seed_seq_generate(
+    Function(XLL_FP, L"?xll_seed_seq_generate", L"RANDOM.SEED.SEQ.GENERATE")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.SEED.SEQ.")
+    .Arg(XLL_WORD, L"Count", L"is the number of new seeds to generate. Default is 1.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Generate new seeds from old seeds.")
 );
-_FP12* WINAPI
-xll_seed_seq_generate(HANDLEX h, WORD n)
+_FP12* WINAPI xll_seed_seq_generate(HANDLEX h, WORD n)
 {
 #pragma XLLEXPORT
-	static FPX s;
+    static FPX result;
 
-	try {
-		handle<engine::seed> h_(h);
-		ensure (h_);
+    try {
+        handle<engine::seed> hs(h);
+        ensure (hs);
 
-		if (n == 0)
-			n = 1;
+        if (n == 0) {
+            n = 1;
+        }
 
-		std::vector<unsigned int> ss(n);
-		h_->generate(ss.begin(), ss.end()); //!!! operator<< does not work on doubles
+        std::vector<std::uint32_t> s(n);
+        hs->generate(s.begin(), s.end());
 
-		s.reshape(n, 1);
-		std::copy(ss.begin(), ss.end(), s.begin());
-	}
-	catch (const std::exception& ex) {
-		XLL_ERROR(ex.what());
+        result.resize(n, 1);
+        std::copy(s.begin(), s.end(), result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
 
-		return 0;
-	}
+        return 0;
+    }
 
-	return s.get();
+    return result.get();
 }
 
-static AddInX xai_seed_seq_param(
-	FunctionX(XLL_FP, _T("?xll_seed_seq_param"), _T("RANDOM.SEED.SEQ.PARAM"))
-	.Arg(XLL_HANDLE, _T("Handle"), _T("is a handle returned by SEED.SEQ. "))
-	.Category(CATEGORY)
-	.FunctionHelp(_T("Return the seed sequence as a one column array. "))
-	.Documentation(
-		_T("The return value can be used as an argument to <codeInline>RANDOM.SEED.SEQ</codeInline>. ")
-	)
+static AddIn xai_seed_seq_param(
+    Function(XLL_FP, L"?xll_seed_seq_param", L"RANDOM.SEED.SEQ.PARAM")
+    .Arg(XLL_HANDLE, L"Handle", L"is a handle returned by RANDOM.SEED.SEQ.")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the seed sequence as a one column array.")
+    .Documentation(LR"xyzzyx(
+The return value can be used as an argument to <codeInline>RANDOM.SEED.SEQ</codeInline>.
+)xyzzyx")
 );
-_FP12* WINAPI
-xll_seed_seq_param(HANDLEX h)
+_FP12* WINAPI xll_seed_seq_param(HANDLEX h)
 {
 #pragma XLLEXPORT
-	static xll::FP12 s;
+    static FPX result;
 
-	try {
-		handle<engine::seed> h_(h);
+    try {
+        handle<engine::seed> hs(h);
+        ensure (hs);
+        ensure (hs->size() > 0);
 
-		s.resize(static_cast<WORD>(h_->size()), 1);
-		h_->param(s.begin());
-	}
-	catch (const std::exception& ex) {
-		XLL_ERROR(ex.what());
+        std::vector<std::uint32_t> s(hs->size());
+        hs->param(s.begin());
 
-		return 0;
-	}
+        result.resize(static_cast<INT32>(s.size()), 1);
+        std::copy(s.begin(), s.end(), result.begin());
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
 
-	return s.get();
-}
+        return 0;
+    }
 
+    return result.get();
+}
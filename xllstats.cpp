@@ -0,0 +1,212 @@
+// xllstats.cpp - generation counters and timing
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include "xllrandom.h"
+
+using namespace xll;
+
+namespace stats = random::stats;
+
+static const wchar_t* stats_header[] = {
+    L"Function", L"Handle", L"Draws", L"Fills", L"Bytes", L"EngineNs", L"DistributionNs", L"OutputNs"
+};
+
+static void stats_row(OPER& o, int i, const stats::totals& t, double ns_per_tick)
+{
+    o(i, 2) = static_cast<double>(t.draws);
+    o(i, 3) = static_cast<double>(t.fills);
+    o(i, 4) = static_cast<double>(t.bytes);
+    for (int j = 0; j < stats::buckets; ++j)
+        o(i, 5 + j) = t.ticks[j]*ns_per_tick;
+}
+
+static AddIn xai_random_stats(
+    Function(XLL_LPOPER, L"?xll_random_stats", L"RANDOM.STATS")
+    .Arg(XLL_HANDLE, L"?Handle", L"is an optional handle to report on. Default is all functions and handles.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return draws, fills, bytes written and nanoseconds spent generating variates.")
+    .Documentation(LR"xyzzyx(
+Counters are kept per thread and summed when this function is called.
+Time is split between the engine, the distribution, and marshalling output to Excel.
+Timing is only recorded if the add-in is built with <codeInline>XLL_RANDOM_TIMING</codeInline> defined.
+Engine fills are timed. Distributions drawing one engine word at a time time every
+64th draw and scale it up, so their engine time is an estimate.
+\n
+If the environment variable <codeInline>XLL_RANDOM_STATS</codeInline> is set to a file name
+the same table is written to that file when the add-in is closed.
+)xyzzyx")
+);
+LPOPER WINAPI xll_random_stats(HANDLEX h)
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        stats::snapshot s;
+        const int n = sizeof(stats_header)/sizeof(*stats_header);
+
+        if (h) {
+            auto i = s.handles.find(h);
+            ensure (i != s.handles.end());
+
+            o = OPER(2, n);
+            for (int j = 0; j < n; ++j)
+                o(0, j) = stats_header[j];
+            o(1, 0) = L"";
+            o(1, 1) = h;
+            stats_row(o, 1, i->second, s.ns_per_tick);
+        }
+        else {
+            o = OPER(1 + static_cast<int>(s.functions.size() + s.handles.size()), n);
+            for (int j = 0; j < n; ++j)
+                o(0, j) = stats_header[j];
+
+            int i = 1;
+            for (const auto& [name, t] : s.functions) {
+                o(i, 0) = name.c_str();
+                o(i, 1) = L"";
+                stats_row(o, i++, t, s.ns_per_tick);
+            }
+            for (const auto& [handle, t] : s.handles) {
+                o(i, 0) = L"";
+                o(i, 1) = handle;
+                stats_row(o, i++, t, s.ns_per_tick);
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+static AddIn xai_random_stats_reset(
+    Function(XLL_BOOL, L"?xll_random_stats_reset", L"RANDOM.STATS.RESET")
+    .Category(CATEGORY)
+    .FunctionHelp(L"Set all counters reported by RANDOM.STATS to zero.")
+);
+BOOL WINAPI xll_random_stats_reset()
+{
+#pragma XLLEXPORT
+    stats::reset();
+
+    return TRUE;
+}
+
+static AddIn xai_random_pool(
+    Function(XLL_LPOPER, L"?xll_random_pool", L"RANDOM.POOL")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return the memory held by the handle object pools.")
+    .Documentation(LR"xyzzyx(
+Engine, seed and distribution handles are allocated from per type pools of
+cache aligned slots. Slots of superseded handles are reused before new memory is requested.
+Each row has the type, bytes per slot, slots allocated, live objects and total bytes.
+)xyzzyx")
+);
+LPOPER WINAPI xll_random_pool()
+{
+#pragma XLLEXPORT
+    static OPER o;
+
+    try {
+        auto f = random::pool_base::reports();
+
+        o = OPER(1 + static_cast<int>(f.size()), 5);
+        o(0, 0) = L"Type";
+        o(0, 1) = L"SlotBytes";
+        o(0, 2) = L"Slots";
+        o(0, 3) = L"Used";
+        o(0, 4) = L"Bytes";
+        for (int i = 0; i < static_cast<int>(f.size()); ++i) {
+            std::string type(f[i].type);
+            o(i + 1, 0) = std::wstring(type.begin(), type.end()).c_str();
+            o(i + 1, 1) = static_cast<double>(f[i].size);
+            o(i + 1, 2) = static_cast<double>(f[i].slots);
+            o(i + 1, 3) = static_cast<double>(f[i].used);
+            o(i + 1, 4) = static_cast<double>(f[i].bytes());
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return &o;
+}
+
+// headless dump for production workbooks
+int xll_random_stats_dump(void)
+{
+    try {
+#pragma warning(suppress: 4996)
+        if (const char* file = std::getenv("XLL_RANDOM_STATS")) {
+            std::wofstream os(file);
+            stats::dump(os);
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Close> xac_random_stats_dump(xll_random_stats_dump);
+
+#ifdef _DEBUG
+
+// counts reach the function and handle rows, erased handles drop out even
+// when erased from another thread during a call
+int xll_test_random_stats(void)
+{
+    try {
+        static const wchar_t* name = L"XLL.TEST.RANDOM.STATS";
+        const double h = -1; // not a valid handle
+        int object;
+
+        {
+            stats::call c(name, h);
+            stats::call::owner(&object);
+            stats::record(100, 800);
+            stats::record(50, 400);
+        }
+        {
+            stats::snapshot s;
+            const auto& f = s.functions[name];
+            ensure (f.draws == 150 && f.fills == 2 && f.bytes == 1200);
+            ensure (s.handles.contains(h));
+            ensure (s.handles[h].draws == 150);
+        }
+
+        {
+            stats::call c(name, h);
+            std::thread([&object]() { stats::erase(&object); }).join();
+            stats::record(1, 8); // the row is still there
+            ensure (!stats::snapshot().handles.contains(h));
+        }
+        {
+            stats::call c(name);
+        }
+        ensure (!stats::snapshot().handles.contains(h));
+        ensure (stats::snapshot().functions[name].draws == 151);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_random_stats(xll_test_random_stats);
+
+#endif // _DEBUG
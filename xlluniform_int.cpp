@@ -0,0 +1,154 @@
+// xlluniform_int.cpp - bounded integers, shuffles and samples
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+#include "uniform_int.h"
+#include "xllrandom.h"
+
+using namespace xll;
+
+static AddIn xai_uniform_int_distribution(
+    Function(XLL_HANDLE, L"?xll_uniform_int_distribution", L"RANDOM.UNIFORM.INT.DISTRIBUTION")
+    .Arg(XLL_DOUBLE, L"a", L"is the minimum integer. Default is 0.")
+    .Arg(XLL_DOUBLE, L"b", L"is the maximum integer. Default is 1.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Uncalced()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return handle to uniformly distributed integers on [a, b].")
+    .Documentation(LR"xyzzyx(
+Uses Lemire's multiply and shift method that only divides when a draw is
+close to being rejected. Use <codeInline>RANDOM.VARIATE</codeInline> to fill a range.
+)xyzzyx")
+);
+HANDLEX WINAPI xll_uniform_int_distribution(double a, double b, HANDLEX e)
+{
+#pragma XLLEXPORT
+    handlex result;
+
+    try {
+        if (a == 0 && b == 0) {
+            b = 1;
+        }
+        typedef random::bulk_variate<distribution::uniform_int<long long>> V;
+        handle<random::variate> h(new V(distribution::uniform_int<long long>(
+            static_cast<long long>(a), static_cast<long long>(b)), random::engine_handle(e)));
+        result = h.get();
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+    }
+
+    return result;
+}
+
+static AddIn xai_random_shuffle(
+    Function(XLL_FP, L"?xll_random_shuffle", L"RANDOM.SHUFFLE")
+    .Arg(XLL_FP, L"Array", L"is an array of numbers to shuffle.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return a random permutation of Array.")
+);
+_FP12* WINAPI xll_random_shuffle(_FP12* pa, HANDLEX e)
+{
+#pragma XLLEXPORT
+    try {
+        random::stats::call call(L"RANDOM.SHUFFLE", e);
+        auto& r = random::engine_handle(e);
+        random::stats::timed<engine::base_engine<>> r_(r);
+
+        distribution::shuffle(r_, pa->array, pa->array + size(*pa));
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return pa;
+}
+
+static AddIn xai_random_sample(
+    Function(XLL_FP, L"?xll_random_sample", L"RANDOM.SAMPLE")
+    .Arg(XLL_DOUBLE, L"Count", L"is the population size.")
+    .Arg(XLL_WORD, L"Size", L"is the number of integers to draw without replacement. Default is 1.")
+    .Arg(XLL_HANDLE, L"?Engine", L"is an optional handle returned by RANDOM.ENGINE.")
+    .Volatile()
+    .Category(CATEGORY)
+    .FunctionHelp(L"Return Size distinct integers from 1 to Count in random order.")
+);
+_FP12* WINAPI xll_random_sample(double n, WORD k, HANDLEX e)
+{
+#pragma XLLEXPORT
+    static FPX s;
+
+    try {
+        random::stats::call call(L"RANDOM.SAMPLE", e);
+        ensure (n >= 1);
+        if (k == 0) {
+            k = 1;
+        }
+
+        s.resize(k, 1);
+        auto& r = random::engine_handle(e);
+        random::stats::call::owner(&r);
+        distribution::sample(r, static_cast<std::uint64_t>(n), k, s.begin());
+        for (WORD i = 0; i < k; ++i) {
+            s[i] += 1;
+        }
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return 0;
+    }
+
+    return s.get();
+}
+
+#ifdef _DEBUG
+
+// engine returning given words
+struct xll_test_words {
+    typedef std::uint64_t result_type;
+    const std::uint64_t* w;
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return ~result_type(0); }
+    result_type operator()() { return *w++; }
+};
+
+int xll_test_uniform_int(void)
+{
+    try {
+        // floor(w s/2^64) unless the low word falls below 2^64 mod s
+        const std::uint64_t w[] = {std::uint64_t(1) << 63, ~std::uint64_t(0), 0, std::uint64_t(1) << 62};
+        xll_test_words e{w};
+        ensure (distribution::bounded(e, 10) == 9); // 2^63 is rejected
+        ensure (e.w == w + 2);
+        ensure (distribution::bounded(e, 3) == 0); // 0 is rejected
+        ensure (e.w == w + 4);
+
+        ensure (distribution::open01(0) == 0x1p-53);
+        ensure (distribution::open01(~std::uint64_t(0)) == 1 - 0x1p-53);
+
+        engine::base<std::mt19937_64> r;
+        for (std::uint64_t s : {1ull, 2ull, 3ull, 7ull, (1ull << 32) + 1, (1ull << 63) + 1}) {
+            for (int i = 0; i < 1000; ++i) {
+                ensure (distribution::bounded(r, s) < s);
+            }
+        }
+        distribution::uniform_int<long long> u(-3, 3);
+        long long x[1000];
+        u.generate(r, 1000, x);
+        ensure (*std::min_element(x, x + 1000) == -3);
+        ensure (*std::max_element(x, x + 1000) == 3);
+    }
+    catch (const std::exception& ex) {
+        XLL_ERROR(ex.what());
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+static Auto<Open> xao_test_uniform_int(xll_test_uniform_int);
+
+#endif // _DEBUG
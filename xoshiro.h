@@ -0,0 +1,216 @@
+// xoshiro.h - xoshiro256++ and xoshiro256** engines with interleaved lanes
+// Copyright (c) KALX, LLC. All rights reserved. No warranty is made.
+// D. Blackman and S. Vigna, Scrambled linear pseudorandom number generators, 2018.
+// See https://prng.di.unimi.it/
+#pragma once
+#include <array>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+
+namespace engine {
+
+	enum class scrambler { plusplus, starstar };
+
+	// L independent xoshiro256 streams, each 2^128 steps apart, stored as
+	// structure of arrays so the steps of different lanes do not depend on each
+	// other. The project sets no /arch flag, so any gain comes from instruction
+	// level parallelism, not from wide vector registers.
+	// Output is interleaved: lane 0, lane 1, ..., lane L - 1, lane 0, ...
+	template<scrambler S, size_t L = 1>
+	class xoshiro256x {
+		alignas(64) std::uint64_t s0[L], s1[L], s2[L], s3[L];
+		alignas(64) std::uint64_t buf[L];
+		size_t i_; // next output in buf
+
+		static std::uint64_t rotl(std::uint64_t x, int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+		static std::uint64_t splitmix64(std::uint64_t& x)
+		{
+			std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+			z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27))*0x94d049bb133111eb;
+
+			return z ^ (z >> 31);
+		}
+
+		// one output per lane
+		void step(std::uint64_t* x)
+		{
+			for (size_t k = 0; k < L; ++k) {
+				if constexpr (S == scrambler::plusplus)
+					x[k] = rotl(s0[k] + s3[k], 23) + s0[k];
+				else
+					x[k] = rotl(s1[k]*5, 7)*9;
+
+				std::uint64_t t = s1[k] << 17;
+				s2[k] ^= s0[k];
+				s3[k] ^= s1[k];
+				s1[k] ^= s2[k];
+				s0[k] ^= s3[k];
+				s2[k] ^= t;
+				s3[k] = rotl(s3[k], 45);
+			}
+		}
+		// advance lane k by 2^128 (jump) or 2^192 (long jump) steps
+		void jump(size_t k, const std::uint64_t (&J)[4])
+		{
+			std::uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+			for (std::uint64_t j : J) {
+				for (int b = 0; b < 64; ++b) {
+					if (j & (std::uint64_t(1) << b)) {
+						t0 ^= s0[k];
+						t1 ^= s1[k];
+						t2 ^= s2[k];
+						t3 ^= s3[k];
+					}
+					std::uint64_t t = s1[k] << 17;
+					s2[k] ^= s0[k];
+					s3[k] ^= s1[k];
+					s1[k] ^= s2[k];
+					s0[k] ^= s3[k];
+					s2[k] ^= t;
+					s3[k] = rotl(s3[k], 45);
+				}
+			}
+			s0[k] = t0;
+			s1[k] = t1;
+			s2[k] = t2;
+			s3[k] = t3;
+		}
+		static constexpr std::uint64_t jump_128[4] = {
+			0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+		};
+		static constexpr std::uint64_t jump_192[4] = {
+			0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635
+		};
+	public:
+		typedef std::uint64_t result_type;
+		static constexpr size_t lanes = L;
+		static constexpr std::uint64_t default_seed = 0x5eed;
+
+		static constexpr result_type (min)()
+		{
+			return 0;
+		}
+		static constexpr result_type (max)()
+		{
+			return ~result_type(0);
+		}
+
+		explicit xoshiro256x(std::uint64_t s = default_seed)
+		{
+			seed(s);
+		}
+		// seed sequences only, so copying a non-const engine is not a reseed
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, xoshiro256x>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		explicit xoshiro256x(Sseq& q)
+		{
+			seed(q);
+		}
+
+		// lane 0 from splitmix64, lane k is lane k - 1 jumped 2^128 steps
+		void seed(std::uint64_t s = default_seed)
+		{
+			std::uint64_t x = s;
+			s0[0] = splitmix64(x);
+			s1[0] = splitmix64(x);
+			s2[0] = splitmix64(x);
+			s3[0] = splitmix64(x);
+			spread();
+		}
+		template<class Sseq>
+			requires (!std::is_same_v<std::remove_cv_t<Sseq>, xoshiro256x>)
+				&& requires(Sseq& s, std::uint32_t* p) { s.generate(p, p); }
+		void seed(Sseq& q)
+		{
+			std::uint32_t w[8];
+			q.generate(w, w + 8);
+			s0[0] = (std::uint64_t(w[1]) << 32) | w[0];
+			s1[0] = (std::uint64_t(w[3]) << 32) | w[2];
+			s2[0] = (std::uint64_t(w[5]) << 32) | w[4];
+			s3[0] = (std::uint64_t(w[7]) << 32) | w[6];
+			if (!(s0[0] | s1[0] | s2[0] | s3[0]))
+				s0[0] = 1; // the all zero state is a fixed point
+			spread();
+		}
+		// state of lane k
+		std::array<std::uint64_t, 4> state(size_t k) const
+		{
+			return {s0[k], s1[k], s2[k], s3[k]};
+		}
+		void state(size_t k, const std::array<std::uint64_t, 4>& s)
+		{
+			s0[k] = s[0];
+			s1[k] = s[1];
+			s2[k] = s[2];
+			s3[k] = s[3];
+			i_ = L;
+		}
+
+		result_type operator()()
+		{
+			if constexpr (L == 1) {
+				result_type x;
+				step(&x);
+
+				return x;
+			}
+			else {
+				if (i_ == L) {
+					step(buf);
+					i_ = 0;
+				}
+
+				return buf[i_++];
+			}
+		}
+		// all lanes are stepped together straight into x
+		void fill(size_t n, result_type* x)
+		{
+			while (n && i_ < L) {
+				*x++ = buf[i_++];
+				--n;
+			}
+			for (; n >= L; n -= L, x += L)
+				step(x);
+			while (n--)
+				*x++ = operator()();
+		}
+		void discard(unsigned long long n)
+		{
+			while (n--)
+				operator()();
+		}
+		// every lane jumps 2^192 steps for non-overlapping subsequences
+		void long_jump()
+		{
+			for (size_t k = 0; k < L; ++k)
+				jump(k, jump_192);
+			i_ = L;
+		}
+	private:
+		void spread()
+		{
+			for (size_t k = 1; k < L; ++k) {
+				s0[k] = s0[k - 1];
+				s1[k] = s1[k - 1];
+				s2[k] = s2[k - 1];
+				s3[k] = s3[k - 1];
+				jump(k, jump_128);
+			}
+			i_ = L;
+		}
+	};
+
+	typedef xoshiro256x<scrambler::plusplus> xoshiro256pp;
+	typedef xoshiro256x<scrambler::starstar> xoshiro256ss;
+	typedef xoshiro256x<scrambler::plusplus, 4> xoshiro256pp_x4;
+	typedef xoshiro256x<scrambler::plusplus, 8> xoshiro256pp_x8;
+	typedef xoshiro256x<scrambler::starstar, 4> xoshiro256ss_x4;
+
+} // namespace engine